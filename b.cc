@@ -1,230 +1,799 @@
+#include "expression_calculus/answer.h"
+#include "expression_calculus/checker.h"
 #include "expression_calculus/expression.h"
 #include "expression_calculus/parsing.h"
+#include "expression_calculus/printing.h"
+#include "expression_calculus/proof_stats.h"
 #include "expression_calculus/rules.h"
+#include "utils/input.h"
+#include "utils/output.h"
+#include "utils/thread_pool.h"
+#include "utils/unix_socket.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
 #include <memory>
-#include <unordered_map>
-#include <unordered_set>
+#include <optional>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
 
-struct Hasher {
-  std::size_t operator()(const std::shared_ptr<Semantic::Expression>& expr) const {
-    assert(expr.use_count() > 0);
-    return expr->memoizedHash;
+#include <condition_variable>
+#include <csignal>
+#include <mutex>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+std::ostream& operator<<(std::ostream& os, const Semantic::Expression& expr) {
+  PrintExpression(os, expr);
+  return os;
+}
+
+struct Options {
+  bool regularParser = false;  // parse via the Regular AST and the prefix
+                               // notation (for differential testing of
+                               // `SemanticParser`)
+  bool hashStats = false;  // report the quality of the expression hashes to
+                           // stderr
+  bool stats = false;  // report the times of the phases and the counters of
+                       // the proof to stderr (as JSON)
+  bool stream = false;  // check the lines as they are read and stop reading at
+                        // the first incorrect one
+  std::size_t threads = 1;  // parse and classify the lines on this many
+                            // threads (0 - one per hardware thread)
+  std::size_t renderCacheBytes = RenderCache::DEFAULT_MEMORY_LIMIT;  // the memory
+                                                                     // limit of the
+                                                                     // rendered texts
+  bool dag = false;  // print the tree in the compact DAG format
+  std::optional<std::uint64_t> maxOutputBytes;  // don't print the classic
+                                                // output if it's larger
+  bool dryRun = false;  // report the size of the classic output instead of
+                        // printing it
+  bool minimize = false;  // print the minimal hilbert-style proof instead of
+                          // converting it
+  std::optional<std::string> batch;  // convert the proofs of this directory
+                                     // (or listed in this file) instead of the
+                                     // standard input
+  std::optional<std::string> daemon;  // serve the proofs sent to this socket
+  std::optional<std::string> connect;  // send the proof to the daemon at this
+                                       // socket
+  double idleTimeout = 10;  // the daemon drops a client that sends or takes
+                            // nothing for this many seconds
+  std::size_t maxInputBytes = SIZE_MAX;  // the limit of the size of a proof
+  std::size_t maxInterned = std::size_t{1} << 22;  // the daemon clears the
+                                                   // interned expressions
+                                                   // between the requests
+                                                   // when there are more
+};
+
+// The exit code when the output exceeds --max-output-bytes
+constexpr int OUTPUT_TOO_LARGE = 2;
+
+constexpr std::size_t PARALLEL_CHUNK_LINES = 1 << 16;
+constexpr std::size_t PARALLEL_GRAIN = 256;
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--regular-parser") {
+      options.regularParser = true;
+    } else if (arg == "--hash-stats") {
+      options.hashStats = true;
+    } else if (arg == "--stats") {
+      options.stats = true;
+    } else if (arg == "--stream") {
+      options.stream = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.threads = std::stoul(argv[++i]);
+    } else if (arg == "--render-cache-bytes" && i + 1 < argc) {
+      options.renderCacheBytes = std::stoull(argv[++i]);
+    } else if (arg == "--dag") {
+      options.dag = true;
+    } else if (arg == "--max-output-bytes" && i + 1 < argc) {
+      options.maxOutputBytes = std::stoull(argv[++i]);
+    } else if (arg == "--dry-run") {
+      options.dryRun = true;
+    } else if (arg == "--minimize") {
+      options.minimize = true;
+    } else if (arg == "--batch" && i + 1 < argc) {
+      options.batch = argv[++i];
+    } else if (arg == "--daemon" && i + 1 < argc) {
+      options.daemon = argv[++i];
+    } else if (arg == "--connect" && i + 1 < argc) {
+      options.connect = argv[++i];
+    } else if (arg == "--idle-timeout" && i + 1 < argc) {
+      options.idleTimeout = std::stod(argv[++i]);
+    } else if (arg == "--max-input-bytes" && i + 1 < argc) {
+      options.maxInputBytes = std::stoull(argv[++i]);
+    } else if (arg == "--max-interned" && i + 1 < argc) {
+      options.maxInterned = std::stoull(argv[++i]);
+    } else {
+      std::cerr << "Unknown option '" << arg << "'" << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [--regular-parser] [--hash-stats] [--stats] [--stream] [--threads N] [--render-cache-bytes N] [--dag] [--max-output-bytes N] [--dry-run] [--minimize] [--batch <dir|list>] [--daemon <socket>] [--connect <socket>] [--idle-timeout SECONDS] [--max-input-bytes N] [--max-interned N] <proof" << std::endl;
+      return false;
+    }
   }
+  return true;
+}
 
-  std::size_t operator()(const std::shared_ptr<Semantic::OwningExpression>& expr) const {
-    assert(expr.use_count() > 0);
-    return expr->root->memoizedHash;
+// Neither of the parsers copies `line`
+template<typename TParser>
+auto MakeLineParser(std::string_view line) {
+  if constexpr (std::is_same_v<TParser, Parser>) {
+    return Parser{std::make_unique<Tokenizer>(line, Tokenizer::NonOwning{})};
+  } else {
+    return TParser{line};
   }
-};
+}
 
-struct ProperSharedPtrComparator {
-  using T = Semantic::Expression;
-  bool operator()(const std::shared_ptr<T>& lhs, const std::shared_ptr<T>& rhs) const {
-    assert(lhs.use_count() > 0);
-    assert(rhs.use_count() > 0);
-    return *lhs == *rhs;
+template<typename TParser>
+bool ParseStatement(
+    std::string_view line,
+    std::vector<std::shared_ptr<Semantic::Expression>>& hypothesesList,
+    std::shared_ptr<Semantic::Expression>& provenExpression,
+    std::ostream& errors) {
+  auto parser = MakeLineParser<TParser>(line);
+  if (!parser.ParseToken(TokenType::TURNSTILE)) {
+    do {
+      hypothesesList.emplace_back(parser.ParseSemantic());
+    } while (parser.ParseToken(TokenType::COMMA));
+    if (!parser.ParseToken(TokenType::TURNSTILE)) {
+      errors << "Turnstile expected, '" << parser.PeekToken() << "' got" << std::endl;
+      return false;
+    }
   }
-};
+  provenExpression = parser.ParseSemantic();
+  assert(parser.IsExhausted());
+  return true;
+}
 
-template<typename TValue>
-using TMap = std::unordered_map<std::shared_ptr<Semantic::Expression>, TValue, Hasher, ProperSharedPtrComparator>;
-
-using TSet = std::unordered_set<std::shared_ptr<Semantic::Expression>, Hasher, ProperSharedPtrComparator>;
-
-void PrintExpression(std::ostream& os, const Semantic::Expression& expr) {
-  using namespace Semantic;
-  switch (expr.GetType()) {
-    case ExpressionType::BOTTOM:
-      os << "_|_";
-      break;
-    case ExpressionType::VARIABLE:
-      os << GetComponent<Variable>(&expr)->expressionView;
-      break;
-    case ExpressionType::CONJUNCTION:
-      os << "(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Conjunction::left));
-      os << ")&(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Conjunction::right));
-      os << ")";
-      break;
-    case ExpressionType::DISJUNCTION:
-      os << "(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Disjunction::left));
-      os << ")|(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Disjunction::right));
-      os << ")";
-      break;
-    case ExpressionType::IMPLICATION:
-      os << "(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Implication::left));
-      os << ")->(";
-      PrintExpression(os, *GetComponent<Expression>(&expr, &Implication::right));
-      os << ")";
-      break;
+// The phases of the regular parser are timed apart in `stats` (the semantic
+// parser tokenizes, parses and converts a line in a single pass)
+template<typename TParser>
+std::shared_ptr<Semantic::Expression> ParseProofLine(std::string_view line, ProofStats* stats) {
+  if constexpr (std::is_same_v<TParser, Parser>) {
+    if (stats != nullptr) {
+      std::unique_ptr<Tokenizer> tokenizer;
+      {
+        PhaseTimer timer{&stats->tokenizing};
+        tokenizer = std::make_unique<Tokenizer>(line, Tokenizer::NonOwning{});
+      }
+      Parser parser{std::move(tokenizer)};
+      std::unique_ptr<Regular::Expression> regular;
+      {
+        PhaseTimer timer{&stats->parsing};
+        regular = parser.ParseExpression();
+      }
+      assert(parser.IsExhausted());
+      PhaseTimer timer{&stats->semanticConversion};
+      return Semantic::OwningExpression{regular.get()}.root;
+    }
   }
+  PhaseTimer timer{PhaseOf(stats, &ProofStats::parsing)};
+  auto parser = MakeLineParser<TParser>(line);
+  auto result = parser.ParseSemantic();
+  assert(parser.IsExhausted());
+  return result;
 }
 
-std::ostream& operator<<(std::ostream& os, const Semantic::Expression& expr) {
-  PrintExpression(os, expr);
-  return os;
+void PrintHashStats(std::ostream& os, const Semantic::Arena& arena) {
+  auto report = arena.CollectHashReport();
+  os << "Interned expressions: " << report.expressions << std::endl;
+  os << "Distinct hashes: " << report.distinctHashes
+     << " (collision rate " << report.CollisionRate() << ")" << std::endl;
+  os << "Interning table: " << arena.BinariesCount() << " binary operations in "
+     << report.buckets << " buckets, " << report.usedBuckets << " used (collision rate "
+     << report.BucketCollisionRate(arena.BinariesCount()) << "), longest chain "
+     << report.longestChain << std::endl;
 }
 
-void PrintAnswer(
-    std::ostream& os,
-    std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
-    const std::shared_ptr<Rules::NaturalNode>& node,
-    std::size_t depth) {
-  // Add new hypothesis that was introduced in current node
-  if (node->addHyp.use_count() > 0) {
-    hypotheses.push_back(node->addHyp);
+void PrintAnswerSize(OutputWriter& output, const AnswerSize& size) {
+  const auto count = [&output] (std::uint64_t value) {
+    output << value << (value == AnswerSize::SATURATED ? " (or more)" : "") << "\n";
+  };
+  output << "Output lines: ";
+  count(size.lines);
+  output << "Output bytes: ";
+  count(size.bytes);
+  output << "Estimation states: " << size.states << "\n";
+}
+
+// What has become of a proof
+enum class Verdict {
+  CONVERTED,
+  NOT_PROVEN,
+  INCORRECT,
+  TOO_LARGE,  // see --max-output-bytes
+  FAILED,
+};
+
+std::string_view VerdictName(Verdict verdict) {
+  switch (verdict) {
+    case Verdict::CONVERTED:
+      return "converted";
+    case Verdict::NOT_PROVEN:
+      return "not proven";
+    case Verdict::INCORRECT:
+      return "incorrect";
+    case Verdict::TOO_LARGE:
+      return "too large";
+    case Verdict::FAILED:
+      return "failed";
   }
+  return {};
+}
+
+// Calls `function` when it goes out of scope
+template<typename TFunction>
+class OnExit {
+public:
+  explicit OnExit(TFunction exitFunction) : function{std::move(exitFunction)} {}
 
+  OnExit(const OnExit&) = delete;
+  OnExit& operator=(const OnExit&) = delete;
+
+  ~OnExit() {
+    function();
+  }
+
+private:
+  TFunction function;
+};
+
+// Checks and converts the proof read from `inputFd`. Why the proof can't be
+// converted (a malformed statement, a too large output) is reported to
+// `errors`. The phases and the
+// counters of the proof are added to `stats` if they are given. Returns the
+// exit code
+int Run(
+    const Options& options,
+    int inputFd,
+    int outputFd,
+    std::ostream& errors,
+    Verdict& verdict,
+    ProofStats* stats = nullptr) {
+  verdict = Verdict::FAILED;
+  const auto parseStatement = options.regularParser ? ParseStatement<Parser> : ParseStatement<SemanticParser>;
+  const auto parseProofLine = options.regularParser ? ParseProofLine<Parser> : ParseProofLine<SemanticParser>;
+
+  std::vector<std::shared_ptr<Semantic::Expression>> hypothesesList;
+  std::shared_ptr<Semantic::Expression> provenExpression;
+
+  LineReader reader{inputFd, options.maxInputBytes};
   {
-    // Traverse children first
-    auto children = node->GetChildren();
-    for (const auto& child : children) {
-      PrintAnswer(os, hypotheses, child, depth + 1);
+    std::optional<std::string_view> firstLine;
+    {
+      PhaseTimer timer{PhaseOf(stats, &ProofStats::reading)};
+      firstLine = reader.NextLine();
+    }
+    if (!parseStatement(firstLine.value_or(std::string_view{}), hypothesesList, provenExpression, errors)) {
+      return 1;
     }
   }
 
-  os << "[" << depth << "] ";
-  if (!hypotheses.empty()) {
-    os << *hypotheses[0].get();
-    for (std::size_t i = 1; i < hypotheses.size(); i++) {
-      os << "," << *hypotheses[i].get();
+  ProofChecker checker{hypothesesList, options.minimize, stats};
+  std::shared_ptr<Semantic::Expression> lastLine;
+  std::size_t incorrectLine = 0;  // 0 if every line is correct
+  std::size_t readLines = 0;
+
+  if (options.stream || options.threads != 1) {
+    // The proof is read in chunks: the lines of a chunk are parsed and
+    // classified (in parallel if there is a pool) and then checked in order.
+    // In the streaming mode a chunk is a single line
+    std::unique_ptr<ThreadPool> pool;
+    std::size_t chunkSize = 1;
+    if (options.threads != 1) {
+      pool = std::make_unique<ThreadPool>(options.threads);
+      chunkSize = PARALLEL_CHUNK_LINES;
+    }
+    std::vector<std::string_view> lines;
+    lines.reserve(chunkSize);
+    std::vector<std::shared_ptr<Semantic::Expression>> expressions(chunkSize);
+    std::vector<ProofChecker::Classification> classifications(chunkSize);
+    const auto prepareLine = [&] (std::size_t i) {
+      expressions[i] = parseProofLine(lines[i], stats);
+      classifications[i] = checker.Classify(expressions[i]);
+    };
+
+    std::size_t lineNumber = 1;
+    bool exhausted = false;
+    while (!exhausted && incorrectLine == 0) {
+      lines.clear();
+      std::size_t count;
+      {
+        PhaseTimer timer{PhaseOf(stats, &ProofStats::reading)};
+        count = reader.NextLines(lines, chunkSize);
+      }
+      readLines += count;
+      exhausted = count < chunkSize;
+      if (pool) {
+        pool->ParallelFor(0, count, PARALLEL_GRAIN, prepareLine);
+      } else {
+        for (std::size_t i = 0; i < count; i++) {
+          prepareLine(i);
+        }
+      }
+      for (std::size_t i = 0; i < count; i++) {
+        lineNumber++;
+        PhaseTimer timer{PhaseOf(stats, &ProofStats::modusPonens)};
+        if (!checker.AddLine(expressions[i], classifications[i])) {
+          incorrectLine = lineNumber;
+          break;
+        }
+      }
+      if (count > 0) {
+        lastLine = expressions[count - 1];
+      }
+    }
+    if (!exhausted) {
+      // The mismatch of the last line is reported instead of the incorrect
+      // line, so the last line is still needed (but the lines before it are
+      // neither parsed nor checked)
+      if (auto proofLine = reader.LastLine()) {
+        lastLine = parseProofLine(*proofLine, stats);
+      }
+    }
+  } else {
+    std::vector<std::shared_ptr<Semantic::Expression>> proof;
+    while (true) {
+      std::optional<std::string_view> proofLine;
+      {
+        PhaseTimer timer{PhaseOf(stats, &ProofStats::reading)};
+        proofLine = reader.NextLine();
+      }
+      if (!proofLine) {
+        break;
+      }
+      proof.emplace_back(parseProofLine(*proofLine, stats));
+    }
+    readLines = proof.size();
+    if (!proof.empty()) {
+      lastLine = proof.back();
+    }
+    if (lastLine && *lastLine == *provenExpression) {
+      for (std::size_t i = 0; i < proof.size(); i++) {
+        // classified apart, so that the rest of `AddLine` is timed alone
+        const auto classification = checker.Classify(proof[i]);
+        PhaseTimer timer{PhaseOf(stats, &ProofStats::modusPonens)};
+        if (!checker.AddLine(proof[i], classification)) {
+          incorrectLine = i + 2;
+          break;
+        }
+      }
     }
   }
-  os << "|-" << *(node->expr.get()) << " [" << node->GetAnnotation() << "]" << std::endl;
 
-  // Pop the hypothesis that was introduced in this node
-  if (node->addHyp.use_count() > 0) {
-    hypotheses.pop_back();
+  OutputWriter output{outputFd};
+  if (stats) {
+    output.CountLines();
+  }
+  const OnExit recordStats{[&] {
+    if (stats == nullptr) {
+      return;
+    }
+    const auto counters = checker.GetCounters();
+    ProofStats::Add(stats->proofs, 1);
+    ProofStats::Add(stats->proofLines, readLines);
+    ProofStats::Add(stats->hypothesisLines, counters.hypotheses);
+    ProofStats::Add(stats->axiomLines, counters.axioms);
+    ProofStats::Add(stats->modusPonensLines, counters.modusPonens);
+    ProofStats::Add(stats->repeatedLines, counters.repeated);
+    ProofStats::Add(stats->precalcMP, counters.precalcMP);
+    ProofStats::Add(stats->inNeedOfLhs, counters.inNeedOfLhs);
+    ProofStats::Add(stats->outputLines, output.LinesWritten());
+    ProofStats::Add(stats->outputBytes, output.BytesWritten());
+  }};
+  if (!lastLine || !(*lastLine == *provenExpression)) {
+    output << "The proof does not prove the required expression\n";
+    verdict = Verdict::NOT_PROVEN;
+    return 0;
+  }
+  if (incorrectLine != 0) {
+    output << "Proof is incorrect at line " << incorrectLine << "\n";
+    verdict = Verdict::INCORRECT;
+    return 0;
   }
-}
 
-int main() {
-  std::ios_base::sync_with_stdio(false);
-  std::cin.tie(nullptr);
+  verdict = Verdict::CONVERTED;
 
-  std::vector<std::unique_ptr<Semantic::OwningExpression>> owningHypothesesList;
-  TSet hypotheses;
-  std::unique_ptr<Semantic::OwningExpression> provenExpression;
-  std::vector<std::unique_ptr<Semantic::OwningExpression>> proof;
+  if (options.minimize) {
+    std::vector<Rules::TPtr> minimal;
+    {
+      PhaseTimer timer{PhaseOf(stats, &ProofStats::treeBuilding)};
+      minimal = checker.Minimize(lastLine);
+    }
+    PhaseTimer timer{PhaseOf(stats, &ProofStats::printing)};
+    PrintProof(output, hypothesesList, *provenExpression, minimal);
+    return 0;
+  }
 
   {
-    std::string firstLine;
-    std::getline(std::cin, firstLine);
-    auto parser = std::make_unique<Parser>(firstLine);
+    // a cache of its own, so that a large proof of a batch or of a daemon
+    // doesn't leave the next ones a full cache
+    RenderCache cache{options.renderCacheBytes};
+    const Rules::NaturalNode* root;
+    {
+      PhaseTimer timer{PhaseOf(stats, &ProofStats::treeBuilding)};
+      root = checker.GetTree(lastLine);
+    }
+    PhaseTimer timer{PhaseOf(stats, &ProofStats::printing)};
+    if (options.dryRun || (options.maxOutputBytes && !options.dag)) {
+      auto size = EstimateAnswer(cache, hypothesesList, root);
+      if (options.dryRun) {
+        PrintAnswerSize(output, size);
+        return 0;
+      }
+      if (size.bytes > *options.maxOutputBytes) {
+        errors << "The output would take " << size.bytes << " bytes (" << size.lines
+                  << " lines), more than --max-output-bytes " << *options.maxOutputBytes << std::endl;
+        verdict = Verdict::TOO_LARGE;
+        return OUTPUT_TOO_LARGE;
+      }
+    }
+    if (options.dag) {
+      PrintDag(output, cache, hypothesesList, root);
+    } else {
+      PrintAnswer(output, cache, hypothesesList, root, 0);
+    }
+  }
+  return 0;
+}
+
+// The proof files of `--batch`: the `*.in` files of a directory or the paths
+// listed in a file, one per line
+std::optional<std::vector<std::string>> ListBatch(const std::string& batch) {
+  namespace fs = std::filesystem;
+  std::vector<std::string> paths;
+  std::error_code error;
+  if (fs::is_directory(batch, error)) {
+    for (const auto& entry : fs::directory_iterator{batch, error}) {
+      if (entry.is_regular_file(error) && entry.path().extension() == ".in") {
+        paths.push_back(entry.path().string());
+      }
+    }
+    std::sort(paths.begin(), paths.end());
+  } else {
+    std::ifstream list{batch};
+    if (!list) {
+      return std::nullopt;
+    }
+    for (std::string line; std::getline(list, line);) {
+      if (!line.empty()) {
+        paths.push_back(line);
+      }
+    }
+  }
+  if (error) {
+    return std::nullopt;
+  }
+  return paths;
+}
+
+// Converts every proof of the batch in one process, `--threads` proofs at a
+// time (the lines of a proof are processed on a single thread). The output of
+// `path` is written to `path.result`; the status and the time of every proof
+// are reported to the standard output. Returns 1 if some proof has failed
+int RunBatch(const Options& options, ProofStats* stats) {
+  auto paths = ListBatch(*options.batch);
+  if (!paths) {
+    std::cerr << "Cannot read the batch '" << *options.batch << "'" << std::endl;
+    return 1;
+  }
 
-    if (parser->ParseToken(TokenType::TURNSTILE)) {
-      provenExpression = parser->ParseOwningExpression();
+  Options proofOptions = options;
+  proofOptions.threads = 1;
+  proofOptions.batch.reset();
+
+  struct Result {
+    Verdict verdict = Verdict::FAILED;
+    int code = 1;
+    std::string error;
+    double milliseconds = 0;
+  };
+  std::vector<Result> results(paths->size());
+  const auto batchStart = std::chrono::steady_clock::now();
+  const auto convert = [&] (std::size_t i) {
+    const auto& path = (*paths)[i];
+    auto& result = results[i];
+    const auto start = std::chrono::steady_clock::now();
+    const int inputFd = open(path.c_str(), O_RDONLY);
+    const std::string outputPath = path + ".result";
+    const int outputFd = inputFd < 0 ? -1 : open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (inputFd < 0 || outputFd < 0) {
+      result.error = std::strerror(errno);
     } else {
-      do {
-        owningHypothesesList.emplace_back(parser->ParseOwningExpression());
-        hypotheses.insert(owningHypothesesList.back()->root);
-      } while (parser->ParseToken(TokenType::COMMA));
-      if (!parser->ParseToken(TokenType::TURNSTILE)) {
-        std::cerr << "Turnstile expected, '" << parser->PeekToken() << "' got" << std::endl;
-        return 1;
+      std::ostringstream errors;
+      try {
+        result.code = Run(proofOptions, inputFd, outputFd, errors, result.verdict, stats);
+        result.error = errors.str();
+        while (!result.error.empty() && result.error.back() == '\n') {
+          result.error.pop_back();
+        }
+      } catch (const std::exception& e) {
+        result.verdict = Verdict::FAILED;
+        result.error = e.what();
       }
-      provenExpression = parser->ParseOwningExpression();
     }
-    assert(parser->IsExhausted());
+    if (inputFd >= 0) {
+      close(inputFd);
+    }
+    if (outputFd >= 0) {
+      close(outputFd);
+    }
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+  {
+    ThreadPool pool{options.threads};
+    pool.ParallelFor(0, paths->size(), 1, convert);
   }
+  const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count();
 
-  for (std::string proofLine; std::getline(std::cin, proofLine) && std::cin.good();) {
-    auto parser = std::make_unique<Parser>(proofLine);
-    proof.emplace_back(parser->ParseOwningExpression());
-    assert(parser->IsExhausted());
+  OutputWriter output{STDOUT_FILENO};
+  std::size_t failed = 0;
+  for (std::size_t i = 0; i < paths->size(); i++) {
+    const auto& result = results[i];
+    std::ostringstream line;
+    line << (*paths)[i] << ": " << VerdictName(result.verdict);
+    if (!result.error.empty()) {
+      line << " (" << result.error << ")";
+    }
+    line << ", " << std::fixed << std::setprecision(3) << result.milliseconds << " ms\n";
+    output << line.str();
+    failed += result.verdict == Verdict::FAILED;
   }
+  std::ostringstream summary;
+  summary << paths->size() << " proofs, " << failed << " failed, " << std::fixed << std::setprecision(3) << elapsed << " ms\n";
+  output << summary.str();
+  return failed > 0 ? 1 : 0;
+}
 
-  if (!(*proof.back() == *provenExpression)) {
-    std::cout << "The proof does not prove the required expression" << std::endl;
-    return 0;
+volatile std::sig_atomic_t daemonStopping = 0;
+
+extern "C" void StopDaemon(int) {
+  daemonStopping = 1;
+}
+
+// Separates the output of a proof sent to the daemon from its status (see
+// `RunDaemon`); the output is text, so it has no such byte
+constexpr char STATUS_MARK = '\0';
+
+// Serves the proofs sent to the socket until SIGINT or SIGTERM. A connection
+// carries a single proof: the client sends it and shuts its side down, the
+// daemon sends back the output, `STATUS_MARK`, the exit code and a line feed,
+// then what `./b <proof` would report to stderr, and closes the connection. A
+// client that sends or takes nothing for `--idle-timeout` seconds is dropped.
+// `--threads` connections are served at once (the others wait in the backlog);
+// the interning arena stays warm between the proofs until it holds more than
+// `--max-interned` expressions, then it is cleared once the requests in flight
+// are done. The other options apply to every proof, so `--max-input-bytes`,
+// `--render-cache-bytes` and `--max-output-bytes` bound the resources of a
+// request
+int RunDaemon(const Options& options, ProofStats* stats) {
+  Options proofOptions = options;
+  proofOptions.threads = 1;
+  proofOptions.daemon.reset();
+
+  struct sigaction action{};
+  action.sa_handler = StopDaemon;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);  // a client may hang up early
+
+  std::unique_ptr<UnixListener> listener;
+  try {
+    listener = std::make_unique<UnixListener>(*options.daemon);
+  } catch (const std::system_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
   }
 
-  const std::size_t N = proof.size();
-
-  TMap<std::shared_ptr<Rules::NaturalNode>> precalcMP;  // Precalculated
-                                                        // expressions that can
-                                                        // be proven via Modus
-                                                        // Ponens
-  TMap<std::shared_ptr<Rules::NaturalNode>> encountered;  // Expressions that
-                                                          // were already
-                                                          // encountered and
-                                                          // proved
-  TMap<std::vector<std::size_t>> inNeedOfLhs;  // Map of following format:
-                                               // a -> {a -> b_1, ..., a -> b_m)
-                                               // (the stored list actually
-                                               // contains the indices in
-                                               // `proof` vector)
-  for (std::size_t i = 0; i < N; i++) {
-    auto pi = proof[i]->root;
-    if (auto prec = precalcMP.find(pi); prec != precalcMP.end()) {
-      // 1. Check if this is modus ponens
-      encountered[prec->first] = prec->second;
-    } else if (hypotheses.find(pi) != hypotheses.end()) {
-      // 2. Check if the expression is in hypotheses
-      encountered[pi] = std::make_shared<Rules::Ax>(Rules::TPtr{}, pi);
-
-      // 3. Try to match to axioms
-    } else if (Rules::MatchAx1(pi.get())) {
-      encountered[pi] = Rules::MakeAx1(pi);
-    } else if (Rules::MatchAx2(pi.get())) {
-      encountered[pi] = Rules::MakeAx2(pi);
-    } else if (Rules::MatchAx3(pi.get())) {
-      encountered[pi] = Rules::MakeAx3(pi);
-    } else if (Rules::MatchAx4(pi.get())) {
-      encountered[pi] = Rules::MakeAx4(pi);
-    } else if (Rules::MatchAx5(pi.get())) {
-      encountered[pi] = Rules::MakeAx5(pi);
-    } else if (Rules::MatchAx6(pi.get())) {
-      encountered[pi] = Rules::MakeAx6(pi);
-    } else if (Rules::MatchAx7(pi.get())) {
-      encountered[pi] = Rules::MakeAx7(pi);
-    } else if (Rules::MatchAx8(pi.get())) {
-      encountered[pi] = Rules::MakeAx8(pi);
-    } else if (Rules::MatchAx9(pi.get())) {
-      encountered[pi] = Rules::MakeAx9(pi);
-    } else if (Rules::MatchAx10(pi.get())) {
-      encountered[pi] = Rules::MakeAx10(pi);
-    } else {
-      std::cout << "Proof is incorrect at line " << i + 2 << std::endl;
-      return 0;
+  // the signals are blocked everywhere except for the wait for a connection
+  // (so they can't slip in between the check of `daemonStopping` and the
+  // wait); the workers inherit the mask
+  sigset_t stopSignals;
+  sigset_t waitMask;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stopSignals, &waitMask);
+  sigdelset(&waitMask, SIGINT);
+  sigdelset(&waitMask, SIGTERM);
+  ThreadPool pool{options.threads};
+
+  std::mutex mutex;
+  std::condition_variable hasSlot;
+  std::size_t serving = 0;
+  const auto idleTimeout = std::chrono::milliseconds{static_cast<long long>(options.idleTimeout * 1000)};
+  const auto serve = [&] (int fd) {
+    Verdict verdict;
+    std::ostringstream errors;
+    int code = 1;
+    bool unread = false;  // the proof has been rejected before it was read
+    try {
+      SetIoTimeout(fd, idleTimeout);
+      code = Run(proofOptions, fd, fd, errors, verdict, stats);
+    } catch (const std::system_error& e) {
+      // the client is too slow or has hung up
+      errors << e.what() << std::endl;
+    } catch (const std::exception& e) {
+      errors << e.what() << std::endl;
+      unread = true;
     }
+    try {
+      OutputWriter output{fd};
+      output << STATUS_MARK << static_cast<std::size_t>(code) << '\n' << errors.str();
+      output.Flush();
+    } catch (const std::system_error&) {
+      // the client is gone
+    }
+    if (unread) {
+      // the rest of the proof is read (and dropped) before the connection is
+      // closed: closing it with unread data would reset it, and the client
+      // could lose the answer
+      shutdown(fd, SHUT_WR);
+      char drop[1 << 12];
+      ssize_t count;
+      do {
+        count = read(fd, drop, sizeof(drop));
+      } while (count > 0 || (count < 0 && errno == EINTR));
+    }
+    close(fd);
+    std::lock_guard lock{mutex};
+    serving--;
+    hasSlot.notify_one();
+  };
 
-    // 4. Modus Ponens precalc (the tree for proof[i] should be present at this stage)
-    if (auto impl = Semantic::GetComponent<Semantic::Implication>(pi.get())) {
-      // here we already need proof for
-      auto a = impl->left;
-      auto b = impl->right;
-      if (auto enc = encountered.find(a); enc != encountered.end()) {
-        precalcMP[b] = std::make_shared<Rules::EImpl>(Rules::TPtr{}, b, encountered[pi], encountered[a]);
-      } else {
-        inNeedOfLhs[a].push_back(i);
+  auto& arena = Semantic::Arena::Global();
+  std::size_t clearedAt = arena.Size();
+  std::cerr << "Listening on " << *options.daemon << std::endl;
+  while (!daemonStopping) {
+    {
+      std::unique_lock lock{mutex};
+      if (arena.Size() - clearedAt > options.maxInterned) {
+        // no request may hold the expressions, the next ones wait in the
+        // backlog meanwhile
+        hasSlot.wait(lock, [&] { return serving == 0; });
+        arena.Clear();
+        clearedAt = arena.Size();
       }
+      hasSlot.wait(lock, [&] { return serving < pool.Size(); });
     }
+    pollfd waitFor{listener->GetFd(), POLLIN, 0};
+    if (ppoll(&waitFor, 1, nullptr, &waitMask) <= 0) {
+      continue;
+    }
+    int fd = listener->Accept();
+    if (fd < 0) {
+      continue;
+    }
+    {
+      std::lock_guard lock{mutex};
+      serving++;
+    }
+    pool.Submit([&serve, fd] { serve(fd); });
+  }
+  pool.Wait();
+  return 0;
+}
 
-    // 5. Second stage of modus pones precalc (clean up inNeedOfLhs)
-    if (auto it = inNeedOfLhs.find(pi); it != inNeedOfLhs.end()) {
-      for (auto j : it->second) {
-        auto pj = proof[j]->root;
-        auto bj = Semantic::GetComponent<Semantic::Implication>(pj.get())->right;
-        precalcMP[bj] = std::make_shared<Rules::EImpl>(Rules::TPtr{}, bj, encountered[pj], encountered[pi]);
+// Sends the proof from the standard input to the daemon and prints its answer
+// (see `RunDaemon`) as `./b <proof` would. Returns the exit code of the proof
+int RunClient(const Options& options) {
+  signal(SIGPIPE, SIG_IGN);
+  int fd;
+  try {
+    fd = ConnectUnix(*options.connect);
+  } catch (const std::system_error& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  const auto copy = [] (int from, int to) {
+    std::vector<char> buffer(std::size_t{1} << 16);
+    OutputWriter output{to};
+    while (true) {
+      ssize_t count = read(from, buffer.data(), buffer.size());
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count <= 0) {
+        return count == 0;
+      }
+      output.Write({buffer.data(), static_cast<std::size_t>(count)});
+    }
+  };
+  bool inputFailed = false;
+  try {
+    inputFailed = !copy(STDIN_FILENO, fd);
+  } catch (const std::system_error&) {
+    // the daemon has stopped reading (e.g. the proof is too large), its answer
+    // tells why
+  }
+  if (inputFailed) {
+    std::cerr << "Failed to read the proof: " << std::strerror(errno) << std::endl;
+  }
+  shutdown(fd, SHUT_WR);
+  std::string status;  // from `STATUS_MARK` on
+  try {
+    std::vector<char> buffer(std::size_t{1} << 16);
+    OutputWriter output{STDOUT_FILENO};
+    while (true) {
+      ssize_t count = read(fd, buffer.data(), buffer.size());
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count < 0) {
+        throw std::system_error{errno, std::generic_category(), "Failed to read the answer"};
       }
+      if (count == 0) {
+        break;
+      }
+      std::string_view chunk{buffer.data(), static_cast<std::size_t>(count)};
+      if (status.empty()) {
+        const std::size_t mark = std::min(chunk.find(STATUS_MARK), chunk.size());
+        output.Write(chunk.substr(0, mark));
+        chunk.remove_prefix(mark);
+      }
+      status.append(chunk);
     }
+  } catch (const std::system_error& e) {
+    std::cerr << e.what() << std::endl;
   }
+  close(fd);
+  const std::size_t lineEnd = status.find('\n');
+  if (lineEnd == std::string::npos) {
+    std::cerr << "The daemon has closed the connection without the status" << std::endl;
+    return 1;
+  }
+  std::cerr << std::string_view{status}.substr(lineEnd + 1) << std::flush;
+  const int code = std::atoi(status.c_str() + 1);
+  return inputFailed ? 1 : code;
+}
 
-  {
-    std::vector<std::shared_ptr<Semantic::Expression>> hyps;
-    hyps.reserve(hypotheses.size());
-    for (const auto &owningHyp : owningHypothesesList) {
-      hyps.emplace_back(owningHyp->root);
+int main(int argc, char* argv[]) {
+  std::ios_base::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+  std::unique_ptr<ProofStats> stats;
+  if (options.stats) {
+    stats = std::make_unique<ProofStats>();
+  }
+  int code;
+  if (options.batch) {
+    code = RunBatch(options, stats.get());
+  } else if (options.daemon) {
+    code = RunDaemon(options, stats.get());
+  } else if (options.connect) {
+    code = RunClient(options);
+  } else {
+    Verdict verdict;
+    try {
+      code = Run(options, STDIN_FILENO, STDOUT_FILENO, std::cerr, verdict, stats.get());
+    } catch (const std::exception& e) {
+      // an input over --max-input-bytes or a malformed line
+      std::cerr << e.what() << std::endl;
+      code = 1;
     }
-    PrintAnswer(std::cout, hyps, encountered[proof.back()->root], 0);
   }
+  if (stats) {
+    stats->PrintJson(std::cerr, options.regularParser ? "regular" : "semantic");
+  }
+  if (options.hashStats) {
+    PrintHashStats(std::cerr, Semantic::Arena::Global());
+  }
+  return code;
 }
@@ -0,0 +1,316 @@
+// Microbenchmarks of the stages of the conversion on generated inputs of a few
+// sizes. Built with the release flags (`make bench`); every benchmark is
+// repeated until it has run for `--min-time` seconds and is reported as
+//   <name> <ops> <ns/op> <throughput> <allocations/op>
+// where the throughput is in lines/s or bytes/s (whichever the benchmark
+// processes). `--filter S` runs only the benchmarks whose names contain S.
+
+#include "expression_calculus/answer.h"
+#include "expression_calculus/checker.h"
+#include "expression_calculus/expression.h"
+#include "expression_calculus/parsing.h"
+#include "expression_calculus/rules.h"
+#include "utils/output.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+// Every allocation of the process is counted
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+template<typename T>
+void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Settings {
+  double minSeconds = 0.3;
+  std::string filter;
+};
+
+enum class Unit {
+  LINES,
+  BYTES,
+};
+
+// Runs `op` (which processes `units` lines or bytes per call) in growing
+// rounds until it has taken `minSeconds` and prints the report line
+template<typename TOp>
+void Measure(const Settings& settings, const std::string& name, Unit unit, double units, TOp op) {
+  if (name.find(settings.filter) == std::string::npos) {
+    return;
+  }
+  op();  // warm-up (e.g. the interning of the expressions)
+  std::size_t ops = 0;
+  std::size_t round = 1;
+  double seconds = 0;
+  std::size_t allocated = 0;
+  while (seconds < settings.minSeconds) {
+    const std::size_t allocationsBefore = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < round; i++) {
+      op();
+    }
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    allocated += allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    ops += round;
+    round *= 2;
+  }
+  std::cout << std::left << std::setw(44) << name << std::right
+            << std::setw(10) << ops
+            << std::setw(14) << std::fixed << std::setprecision(1) << seconds * 1e9 / ops << " ns/op"
+            << std::setw(14) << std::setprecision(0) << units * ops / seconds
+            << (unit == Unit::LINES ? " lines/s" : " bytes/s")
+            << std::setw(12) << std::setprecision(2) << static_cast<double>(allocated) / ops << " allocs/op"
+            << std::endl;
+}
+
+/*******************************************************************************
+*                                   Inputs                                    *
+*******************************************************************************/
+
+// A formula of `2^depth` variables, the operators of the levels alternate
+std::string Balanced(std::size_t depth, std::size_t& variable) {
+  if (depth == 0) {
+    return "V" + std::to_string(variable++);
+  }
+  static const char* operators[] = {"&", "|", "->"};
+  const std::string lhs = Balanced(depth - 1, variable);
+  const std::string rhs = Balanced(depth - 1, variable);
+  return "(" + lhs + operators[depth % 3] + rhs + ")";
+}
+
+std::string Balanced(std::size_t depth) {
+  std::size_t variable = 0;
+  return Balanced(depth, variable);
+}
+
+// An instance of every axiom scheme (1..10) with formulas of `depth` in place
+// of the metavariables
+std::vector<std::string> AxiomInstances(std::size_t depth) {
+  std::size_t variable = 0;
+  const std::string p = "(" + Balanced(depth, variable) + ")";
+  const std::string q = "(" + Balanced(depth, variable) + ")";
+  const std::string r = "(" + Balanced(depth, variable) + ")";
+  return {
+    p + "->" + q + "->" + p,
+    "(" + p + "->" + q + ")->(" + p + "->" + q + "->" + r + ")->(" + p + "->" + r + ")",
+    p + "->" + q + "->" + p + "&" + q,
+    p + "&" + q + "->" + p,
+    p + "&" + q + "->" + q,
+    p + "->" + p + "|" + q,
+    q + "->" + p + "|" + q,
+    "(" + p + "->" + r + ")->(" + q + "->" + r + ")->(" + p + "|" + q + "->" + r + ")",
+    "(" + p + "->" + q + ")->(" + p + "->!" + q + ")->!" + p,
+    p + "->!" + p + "->" + q,
+  };
+}
+
+struct Proof {
+  std::vector<Rules::TPtr> hypotheses;
+  std::vector<Rules::TPtr> lines;
+};
+
+Proof MakeProof(const std::vector<std::string>& hypotheses, const std::vector<std::string>& lines) {
+  Proof proof;
+  for (const auto& hypothesis : hypotheses) {
+    proof.hypotheses.push_back(SemanticParser{hypothesis}.ParseSemantic());
+  }
+  for (const auto& line : lines) {
+    proof.lines.push_back(SemanticParser{line}.ParseSemantic());
+  }
+  return proof;
+}
+
+// A proof of `A` from `A` of `2 * steps + 2` distinct lines: every step is an
+// instance of the first axiom scheme and a modus ponens
+Proof WideProof(std::size_t steps) {
+  std::vector<std::string> lines{"A"};
+  for (std::size_t i = 0; i < steps; i++) {
+    const std::string c = "C" + std::to_string(i);
+    lines.push_back("A->" + c + "->A");
+    lines.push_back(c + "->A");
+  }
+  lines.push_back("A");
+  return MakeProof({"A"}, lines);
+}
+
+// A proof of `A` from `A,A->A` whose tree is a chain of `steps` modus ponens
+Proof DeepProof(std::size_t steps) {
+  std::vector<std::string> lines{"A"};
+  for (std::size_t i = 0; i < steps; i++) {
+    lines.push_back("A->A");
+    lines.push_back("A");
+  }
+  return MakeProof({"A", "A->A"}, lines);
+}
+
+/*******************************************************************************
+*                                 Benchmarks                                  *
+*******************************************************************************/
+
+void BenchParsing(const Settings& settings) {
+  for (std::size_t depth : {3, 7, 11}) {
+    const std::string line = Balanced(depth);
+    const std::string suffix = " (" + std::to_string(line.size()) + " B)";
+    Measure(settings, "Tokenizer" + suffix, Unit::BYTES, line.size(), [&] {
+      Tokenizer tokenizer{std::string_view{line}, Tokenizer::NonOwning{}};
+      DoNotOptimize(tokenizer);
+    });
+    Measure(settings, "Parser::ParseOwningExpression" + suffix, Unit::BYTES, line.size(), [&] {
+      auto expr = Parser{line}.ParseOwningExpression();
+      DoNotOptimize(expr);
+    });
+    Measure(settings, "SemanticParser::ParseSemantic" + suffix, Unit::BYTES, line.size(), [&] {
+      auto expr = SemanticParser{line}.ParseSemantic();
+      DoNotOptimize(expr);
+    });
+  }
+}
+
+constexpr std::size_t MAKES_PER_ARENA = 64;
+
+void BenchAxioms(const Settings& settings) {
+  using TMatcher = bool(*)(const Semantic::Expression*);
+  static constexpr TMatcher matchers[Rules::AXIOM_SCHEMES] = {
+    Rules::MatchAx1, Rules::MatchAx2, Rules::MatchAx3, Rules::MatchAx4, Rules::MatchAx5,
+    Rules::MatchAx6, Rules::MatchAx7, Rules::MatchAx8, Rules::MatchAx9, Rules::MatchAx10,
+  };
+  const auto instances = AxiomInstances(3);
+  for (std::size_t i = 0; i < instances.size(); i++) {
+    const std::size_t scheme = i + 1;
+    auto expr = SemanticParser{instances[i]}.ParseSemantic();
+    if (!matchers[i](expr.get())) {
+      std::cerr << "The instance of the axiom scheme " << scheme << " doesn't match it" << std::endl;
+      std::abort();
+    }
+    const std::string number = std::to_string(scheme);
+    Measure(settings, "MatchAx" + number, Unit::BYTES, instances[i].size(), [&] {
+      DoNotOptimize(matchers[i](expr.get()));
+    });
+    // (an instance of the 9th scheme is an instance of the 2nd one as well)
+    Measure(settings, "ClassifyAxiom (scheme " + number + ")", Unit::BYTES, instances[i].size(), [&] {
+      DoNotOptimize(Rules::ClassifyAxiom(expr.get()));
+    });
+    // a new arena for every `MAKES_PER_ARENA` trees, so that the memory
+    // doesn't grow with the number of runs
+    Measure(settings, "MakeAx" + number + " (x" + std::to_string(MAKES_PER_ARENA) + ")", Unit::BYTES, MAKES_PER_ARENA * instances[i].size(), [&] {
+      Rules::NodeArena nodes;
+      for (std::size_t j = 0; j < MAKES_PER_ARENA; j++) {
+        DoNotOptimize(Rules::MakeAx(nodes, scheme, expr));
+      }
+    });
+  }
+}
+
+void BenchProofs(const Settings& settings) {
+  for (std::size_t steps : {1000, 100000}) {
+    const Proof proof = WideProof(steps);
+    Measure(settings, "MP loop (" + std::to_string(proof.lines.size()) + " lines)", Unit::LINES, proof.lines.size(), [&] {
+      ProofChecker checker{proof.hypotheses};
+      for (const auto& line : proof.lines) {
+        DoNotOptimize(checker.AddLine(line));
+      }
+    });
+  }
+
+  const int devNull = open("/dev/null", O_WRONLY);
+  for (std::size_t steps : {1000, 100000}) {
+    const Proof proof = DeepProof(steps);
+    ProofChecker checker{proof.hypotheses};
+    for (const auto& line : proof.lines) {
+      checker.AddLine(line);
+    }
+    const auto* root = checker.GetTree(proof.lines.back());
+    RenderCache sizeCache;
+    const auto size = EstimateAnswer(sizeCache, proof.hypotheses, root);
+    // (the trees are memoized by the checker, so it is built anew every time)
+    Measure(settings, "MP loop and GetTree (" + std::to_string(proof.lines.size()) + " lines, deep)", Unit::LINES, proof.lines.size(), [&] {
+      ProofChecker fresh{proof.hypotheses};
+      for (const auto& line : proof.lines) {
+        fresh.AddLine(line);
+      }
+      DoNotOptimize(fresh.GetTree(proof.lines.back()));
+    });
+    Measure(settings, "PrintAnswer (" + std::to_string(size.lines) + " lines)", Unit::BYTES, size.bytes, [&] {
+      RenderCache cache;
+      OutputWriter output{devNull};
+      PrintAnswer(output, cache, proof.hypotheses, root, 0);
+    });
+  }
+  close(devNull);
+}
+
+bool ParseOptions(int argc, char* argv[], Settings& settings) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--min-time" && i + 1 < argc) {
+      settings.minSeconds = std::stod(argv[++i]);
+    } else if (arg == "--filter" && i + 1 < argc) {
+      settings.filter = argv[++i];
+    } else {
+      std::cerr << "Unknown option '" << arg << "'" << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [--min-time SECONDS] [--filter S]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Settings settings;
+  if (!ParseOptions(argc, argv, settings)) {
+    return 1;
+  }
+  BenchParsing(settings);
+  BenchAxioms(settings);
+  BenchProofs(settings);
+  return 0;
+}
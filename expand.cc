@@ -0,0 +1,159 @@
+// Expands the compact DAG output of `b --dag` to the classic format.
+//
+// The format:
+//   dag 1
+//   hyp <formula>        (the hypotheses of the statement, in order)
+//   ...
+//   <number> <annotation> <added hypothesis or -> <formula> [<child number>...]
+//   ...
+// The nodes are numbered from 0 in the order of the lines, every node comes
+// after its children and the last one is the root. The formulas are written
+// without spaces exactly as in the classic format.
+//
+// Any other input (e.g. an error message) is copied as is.
+
+#include "utils/input.h"
+#include "utils/output.h"
+
+#include <charconv>
+#include <iostream>
+#include <system_error>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+struct Node {
+  std::string annotation;
+  std::string addHyp;  // empty if the context is the same as parent's
+  std::string expr;
+  std::vector<std::size_t> children;
+};
+
+// Splits `line` by spaces
+std::vector<std::string_view> Fields(std::string_view line) {
+  std::vector<std::string_view> fields;
+  while (!line.empty()) {
+    auto end = line.find(' ');
+    if (end != 0) {
+      fields.push_back(line.substr(0, end));
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    line.remove_prefix(end + 1);
+  }
+  return fields;
+}
+
+// Rejects anything but decimal digits and the values that don't fit
+bool ParseNumber(std::string_view s, std::size_t& result) {
+  const char* end = s.data() + s.size();
+  auto [parsed, error] = std::from_chars(s.data(), end, result);
+  return error == std::errc{} && parsed == end;
+}
+
+bool ParseNode(std::string_view line, std::size_t number, Node& node) {
+  auto fields = Fields(line);
+  std::size_t lineNumber;
+  if (fields.size() < 4 || !ParseNumber(fields[0], lineNumber) || lineNumber != number) {
+    return false;
+  }
+  node.annotation = fields[1];
+  node.addHyp = fields[2] == "-" ? std::string{} : std::string{fields[2]};
+  node.expr = fields[3];
+  for (std::size_t i = 4; i < fields.size(); i++) {
+    std::size_t child;
+    if (!ParseNumber(fields[i], child) || child >= number) {
+      return false;
+    }
+    node.children.push_back(child);
+  }
+  return true;
+}
+
+// Same traversal as `PrintAnswer` in expression_calculus/answer.h
+void Expand(OutputWriter& output, const std::vector<std::string>& hypotheses, const std::vector<Node>& nodes) {
+  std::string context;
+  std::vector<std::size_t> contextEnds;
+  const auto push = [&] (std::string_view hypothesis) {
+    contextEnds.push_back(context.size());
+    if (!context.empty()) {
+      context.push_back(',');
+    }
+    context.append(hypothesis);
+  };
+  for (const auto& hypothesis : hypotheses) {
+    push(hypothesis);
+  }
+
+  struct Frame {
+    const Node* node;
+    std::size_t nextChild;
+  };
+  std::vector<Frame> stack;
+  const auto enter = [&] (const Node& node) {
+    if (!node.addHyp.empty()) {
+      push(node.addHyp);
+    }
+    stack.push_back({&node, 0});
+  };
+  enter(nodes.back());
+  while (!stack.empty()) {
+    auto& [node, nextChild] = stack.back();
+    if (nextChild < node->children.size()) {
+      enter(nodes[node->children[nextChild++]]);
+      continue;
+    }
+    output << "[" << stack.size() - 1 << "] " << context << "|-" << node->expr << " [" << node->annotation << "]\n";
+    if (!node->addHyp.empty()) {
+      context.resize(contextEnds.back());
+      contextEnds.pop_back();
+    }
+    stack.pop_back();
+  }
+}
+
+}  // namespace
+
+int main() {
+  LineReader reader{STDIN_FILENO};
+  OutputWriter output{STDOUT_FILENO};
+
+  auto header = reader.NextLine();
+  if (!header) {
+    return 0;
+  }
+  if (*header != "dag 1") {
+    // not a tree, copy the input
+    output << *header << "\n";
+    while (auto line = reader.NextLine()) {
+      output << *line << "\n";
+    }
+    return 0;
+  }
+
+  std::vector<std::string> hypotheses;
+  std::vector<Node> nodes;
+  while (auto line = reader.NextLine()) {
+    if (nodes.empty() && line->substr(0, 4) == "hyp ") {
+      hypotheses.emplace_back(line->substr(4));
+      continue;
+    }
+    Node node;
+    if (!ParseNode(*line, nodes.size(), node)) {
+      std::cerr << "Malformed node at line " << nodes.size() + hypotheses.size() + 2 << std::endl;
+      return 1;
+    }
+    nodes.push_back(std::move(node));
+  }
+  if (nodes.empty()) {
+    std::cerr << "No nodes" << std::endl;
+    return 1;
+  }
+  Expand(output, hypotheses, nodes);
+  return 0;
+}
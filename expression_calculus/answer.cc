@@ -0,0 +1,114 @@
+#include "answer.h"
+
+namespace {
+
+std::uint64_t SaturatingAdd(std::uint64_t a, std::uint64_t b) {
+  return a > AnswerSize::SATURATED - b ? AnswerSize::SATURATED : a + b;
+}
+
+std::uint64_t SaturatingMul(std::uint64_t a, std::uint64_t b) {
+  return b != 0 && a > AnswerSize::SATURATED / b ? AnswerSize::SATURATED : a * b;
+}
+
+std::uint64_t DecimalDigits(std::size_t value) {
+  std::uint64_t digits = 1;
+  for (; value >= 10; value /= 10) {
+    digits++;
+  }
+  return digits;
+}
+
+struct State {
+  const Rules::NaturalNode* node;
+  std::size_t depth;
+  bool emptyContext;
+
+  bool operator==(const State& other) const {
+    return node == other.node && depth == other.depth && emptyContext == other.emptyContext;
+  }
+};
+
+struct StateHasher {
+  std::size_t operator()(const State& state) const {
+    return Semantic::MixHash(std::hash<const void*>{}(state.node) ^ Semantic::MixHash(state.depth * 2 + state.emptyContext));
+  }
+};
+
+// The size of the output of a subtree whose context has the length L is
+// `base + lines * L`
+struct SubtreeSize {
+  std::uint64_t lines = 0;
+  std::uint64_t base = 0;
+};
+
+}  // namespace
+
+AnswerSize EstimateAnswer(
+    RenderCache& cache,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
+    const Rules::NaturalNode* root) {
+  std::uint64_t contextLength = 0;
+  for (const auto& hypothesis : hypotheses) {
+    contextLength += cache.TextLength(*hypothesis) + (contextLength > 0 ? 1 : 0);
+  }
+
+  std::unordered_map<State, SubtreeSize, StateHasher> memo;
+  struct Frame {
+    State state;
+    std::uint64_t added;  // the length the node adds to the context (with
+                          // the comma)
+    std::size_t nextChild;
+    SubtreeSize size;
+  };
+  std::vector<Frame> stack;
+  // `base` of the node's own line, the children are added as they are done
+  const auto enter = [&] (const State& state) {
+    const auto* node = state.node;
+    std::uint64_t added = 0;
+    if (node->addHyp != nullptr) {
+      added = cache.TextLength(*node->addHyp) + (state.emptyContext ? 0 : 1);
+    }
+    // "[depth] context|-expr [annotation]\n"
+    std::uint64_t line = DecimalDigits(state.depth) + added + cache.TextLength(*node->expr) + node->GetAnnotation().size() + 9;
+    stack.push_back({state, added, 0, SubtreeSize{1, line}});
+  };
+  // Adds the size of a child subtree to the size of its parent on the top
+  const auto addChild = [&] (const SubtreeSize& child) {
+    auto& parent = stack.back();
+    parent.size.lines = SaturatingAdd(parent.size.lines, child.lines);
+    parent.size.base = SaturatingAdd(parent.size.base, SaturatingAdd(child.base, SaturatingMul(child.lines, parent.added)));
+  };
+
+  SubtreeSize total;
+  enter(State{root, 0, hypotheses.empty()});
+  while (!stack.empty()) {
+    auto& frame = stack.back();
+    if (frame.nextChild < frame.state.node->ChildrenCount()) {
+      State child{
+        frame.state.node->GetChild(frame.nextChild++),
+        frame.state.depth + 1,
+        frame.state.emptyContext && frame.added == 0};
+      if (auto it = memo.find(child); it != memo.end()) {
+        addChild(it->second);
+      } else {
+        enter(child);
+      }
+      continue;
+    }
+    const State state = frame.state;
+    const SubtreeSize size = frame.size;
+    stack.pop_back();
+    memo.emplace(state, size);
+    if (stack.empty()) {
+      total = size;
+    } else {
+      addChild(size);
+    }
+  }
+
+  AnswerSize result;
+  result.lines = total.lines;
+  result.bytes = SaturatingAdd(total.base, SaturatingMul(total.lines, contextLength));
+  result.states = memo.size();
+  return result;
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "expression.h"
+#include "printing.h"
+#include "rules.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*******************************************************************************
+*                                Classic format                               *
+*******************************************************************************/
+
+// The rendered context ("h1,h2,...,hk") of the node being printed. The
+// contexts of adjacent nodes differ only by the hypothesis at the end, so the
+// text is extended and truncated instead of being rendered on every line
+class ContextBuffer {
+public:
+  ContextBuffer(RenderCache& renderCache) : cache{renderCache} {}
+
+  void Push(const Semantic::Expression& hypothesis) {
+    ends.push_back(text.size());
+    if (!text.empty()) {
+      text.push_back(',');
+    }
+    cache.Print(*this, hypothesis);
+  }
+
+  void Pop() {
+    text.resize(ends.back());
+    ends.pop_back();
+  }
+
+  std::string_view GetText() const {
+    return text;
+  }
+
+  // For `RenderCache::Print`
+  ContextBuffer& operator<<(std::string_view s) {
+    text.append(s);
+    return *this;
+  }
+
+private:
+  RenderCache& cache;
+  std::string text;
+  std::vector<std::size_t> ends;  // the lengths of `text` before the pushes
+};
+
+// Prints the tree in post-order (children first) with an explicit stack, so
+// the depth of the tree is limited only by the memory
+template<typename TOutput>
+void PrintAnswer(
+    TOutput& os,
+    RenderCache& cache,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
+    const Rules::NaturalNode* root,
+    std::size_t rootDepth) {
+  struct Frame {
+    const Rules::NaturalNode* node;
+    std::size_t nextChild;
+  };
+  std::vector<Frame> stack;
+  ContextBuffer context{cache};
+  for (const auto& hypothesis : hypotheses) {
+    context.Push(*hypothesis);
+  }
+  const auto enter = [&] (const Rules::NaturalNode* node) {
+    // Add new hypothesis that was introduced in current node
+    if (node->addHyp != nullptr) {
+      context.Push(*node->addHyp);
+    }
+    stack.push_back({node, 0});
+  };
+
+  enter(root);
+  while (!stack.empty()) {
+    auto& [node, nextChild] = stack.back();
+    if (nextChild < node->ChildrenCount()) {
+      // Traverse children first
+      enter(node->GetChild(nextChild++));
+      continue;
+    }
+
+    os << "[" << rootDepth + stack.size() - 1 << "] " << context.GetText() << "|-";
+    cache.Print(os, *node->expr);
+    os << " [" << node->GetAnnotation() << "]\n";
+
+    // Pop the hypothesis that was introduced in this node
+    if (node->addHyp != nullptr) {
+      context.Pop();
+    }
+    stack.pop_back();
+  }
+}
+
+/*******************************************************************************
+*                                  DAG format                                 *
+*******************************************************************************/
+
+// Prints the tree in the compact DAG format: every distinct node once, after
+// its children, referring to them by number (see `expand.cc` for the format and
+// the conversion back)
+template<typename TOutput>
+void PrintDag(
+    TOutput& os,
+    RenderCache& cache,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
+    const Rules::NaturalNode* root) {
+  os << "dag 1\n";
+  for (const auto& hypothesis : hypotheses) {
+    os << "hyp ";
+    cache.Print(os, *hypothesis);
+    os << "\n";
+  }
+
+  std::unordered_map<const Rules::NaturalNode*, std::size_t> numbers;
+  struct Frame {
+    const Rules::NaturalNode* node;
+    std::size_t nextChild;
+  };
+  std::vector<Frame> stack{{root, 0}};
+  while (!stack.empty()) {
+    auto& [node, nextChild] = stack.back();
+    if (nextChild < node->ChildrenCount()) {
+      const auto* child = node->GetChild(nextChild++);
+      if (numbers.count(child) == 0) {
+        stack.push_back({child, 0});
+      }
+      continue;
+    }
+    if (numbers.count(node) == 0) {
+      const std::size_t number = numbers.size();
+      numbers.emplace(node, number);
+      os << number << " " << node->GetAnnotation() << " ";
+      if (node->addHyp != nullptr) {
+        cache.Print(os, *node->addHyp);
+      } else {
+        os << "-";
+      }
+      os << " ";
+      cache.Print(os, *node->expr);
+      for (std::size_t i = 0; i < node->ChildrenCount(); i++) {
+        os << " " << numbers.at(node->GetChild(i));
+      }
+      os << "\n";
+    }
+    stack.pop_back();
+  }
+}
+
+/*******************************************************************************
+*                                Hilbert format                               *
+*******************************************************************************/
+
+// Prints a hilbert-style proof in the input format: the statement and then the
+// lines (each is printed once, so there is no need for a cache)
+template<typename TOutput>
+void PrintProof(
+    TOutput& os,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
+    const Semantic::Expression& proven,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& lines) {
+  for (std::size_t i = 0; i < hypotheses.size(); i++) {
+    if (i > 0) {
+      os << ",";
+    }
+    PrintInputExpression(os, *hypotheses[i]);
+  }
+  os << "|-";
+  PrintInputExpression(os, proven);
+  os << "\n";
+  for (const auto& line : lines) {
+    PrintInputExpression(os, *line);
+    os << "\n";
+  }
+}
+
+/*******************************************************************************
+*                               Size estimation                               *
+*******************************************************************************/
+
+// The exact size of the output of `PrintAnswer`. The counts saturate at the
+// maximum of `std::uint64_t`
+struct AnswerSize {
+  static constexpr std::uint64_t SATURATED = UINT64_MAX;
+
+  std::uint64_t lines = 0;
+  std::uint64_t bytes = 0;
+  std::size_t states = 0;  // the distinct (node, depth, empty context) triples
+                           // that were visited
+};
+
+// Computes the size of the output without printing it. The size of a subtree
+// is memoized per node, depth and whether the context is empty: the length of
+// the context adds just `lines * length` bytes. So the time is proportional to
+// the number of such triples rather than to the size of the output
+AnswerSize EstimateAnswer(
+    RenderCache& cache,
+    const std::vector<std::shared_ptr<Semantic::Expression>>& hypotheses,
+    const Rules::NaturalNode* root);
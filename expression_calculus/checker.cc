@@ -0,0 +1,167 @@
+#include "checker.h"
+
+ProofChecker::Classification ProofChecker::Classify(const Rules::TPtr& line) const {
+  Classification result;
+  {
+    PhaseTimer timer{PhaseOf(stats, &ProofStats::hypothesisLookup)};
+    result.hypothesis = hypotheses.Contains(*line);
+  }
+  if (!result.hypothesis) {
+    // timed by the scheme found, so the timer is not scoped
+    const auto start = stats ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    result.scheme = Rules::ClassifyAxiom(line.get());
+    if (stats) {
+      stats->axiomMatching[result.scheme].Add(std::chrono::steady_clock::now() - start);
+    }
+  }
+  return result;
+}
+
+bool ProofChecker::AddLine(const Rules::TPtr& pi, const Classification& classification) {
+  using Kind = Justification::Kind;
+  if (preferShallowest) {
+    // 0. A repeated line can't give a shallower justification, nor anything
+    // new to the modus ponens precalc
+    if (encountered.Contains(*pi)) {
+      counters.repeated++;
+      return true;
+    }
+  }
+  const TIndex* prec = precalcMP.Find(*pi);
+  if (preferShallowest && (classification.hypothesis || classification.scheme != Rules::NOT_AN_AXIOM)) {
+    // a hypothesis or an axiom is shallower than any modus ponens
+    prec = nullptr;
+  }
+  if (prec != nullptr) {
+    // 1. Check if this is modus ponens
+    encountered[*pi] = *prec;
+    counters.modusPonens++;
+  } else if (classification.hypothesis) {
+    // 2. Check if the expression is in hypotheses
+    const TIndex justification = AddJustification({pi, Kind::HYPOTHESIS});
+    encountered[*pi] = justification;
+    counters.hypotheses++;
+
+    // 3. Try to match to axioms
+  } else if (classification.scheme != Rules::NOT_AN_AXIOM) {
+    const TIndex justification = AddJustification({pi, Kind::AXIOM, static_cast<std::uint8_t>(classification.scheme)});
+    encountered[*pi] = justification;
+    counters.axioms++;
+  } else {
+    return false;
+  }
+
+  // 4. Modus Ponens precalc (the justification of pi should be present at this
+  // stage)
+  if (auto impl = Semantic::GetComponent<Semantic::Implication>(pi.get())) {
+    // here we already need proof for
+    const auto& a = impl->left;
+    const auto& b = impl->right;
+    if (const TIndex* enc = encountered.Find(*a)) {
+      AddModusPonens(b, *encountered.Find(*pi), *enc);
+    } else {
+      assert(waiting.size() < NO_LINE);
+      const TIndex index = waiting.size();
+      waiting.push_back({pi.get()});
+      auto& list = inNeedOfLhs[*a];
+      if (list.head == NO_LINE) {
+        list.head = index;
+      } else {
+        waiting[list.tail].next = index;
+      }
+      list.tail = index;
+    }
+  }
+
+  // 5. Second stage of modus pones precalc (clean up inNeedOfLhs)
+  if (const WaitingList* list = inNeedOfLhs.Find(*pi)) {
+    const TIndex premise = *encountered.Find(*pi);
+    for (TIndex j = list->head; j != NO_LINE; j = waiting[j].next) {
+      const auto* pj = waiting[j].implication;
+      const auto& bj = Semantic::GetComponent<Semantic::Implication>(pj)->right;
+      AddModusPonens(bj, *encountered.Find(*pj), premise);
+    }
+  }
+  return true;
+}
+
+void ProofChecker::AddModusPonens(const Rules::TPtr& b, TIndex implication, TIndex premise) {
+  const TIndex depth = std::max(justifications[implication].depth, justifications[premise].depth) + 1;
+  if (preferShallowest) {
+    if (const TIndex* prec = precalcMP.Find(*b); prec != nullptr && justifications[*prec].depth <= depth) {
+      return;
+    }
+  }
+  const TIndex justification = AddJustification({b, Justification::Kind::MODUS_PONENS, 0, implication, premise, depth});
+  precalcMP[*b] = justification;
+}
+
+const Rules::NaturalNode* ProofChecker::GetTree(const Rules::TPtr& expr) {
+  using Kind = Justification::Kind;
+  trees.resize(justifications.size(), nullptr);
+  // Post-order over the justifications that have no tree yet, with an explicit
+  // stack: a chain of modus ponens may be as long as the proof
+  assert(encountered.Contains(*expr));
+  std::vector<TIndex> stack{*encountered.Find(*expr)};
+  while (!stack.empty()) {
+    const TIndex index = stack.back();
+    if (trees[index] != nullptr) {
+      stack.pop_back();
+      continue;
+    }
+    const auto& justification = justifications[index];
+    switch (justification.kind) {
+      case Kind::HYPOTHESIS:
+        trees[index] = nodes.Make<Rules::Ax>(Rules::TPtr{}, justification.expr);
+        break;
+      case Kind::AXIOM:
+        trees[index] = Rules::MakeAx(nodes, justification.scheme, justification.expr);
+        break;
+      case Kind::MODUS_PONENS:
+        if (trees[justification.implication] == nullptr) {
+          stack.push_back(justification.implication);
+          continue;
+        }
+        if (trees[justification.premise] == nullptr) {
+          stack.push_back(justification.premise);
+          continue;
+        }
+        trees[index] = nodes.Make<Rules::EImpl>(
+            Rules::TPtr{}, justification.expr, trees[justification.implication], trees[justification.premise]);
+        break;
+    }
+    stack.pop_back();
+  }
+  return trees[*encountered.Find(*expr)];
+}
+
+std::vector<Rules::TPtr> ProofChecker::Minimize(const Rules::TPtr& expr) const {
+  using Kind = Justification::Kind;
+  assert(preferShallowest);
+  // A justification is added after the ones it refers to, so the order of the
+  // indices is an order of checking
+  std::vector<bool> needed(justifications.size(), false);
+  assert(encountered.Contains(*expr));
+  std::vector<TIndex> stack{*encountered.Find(*expr)};
+  while (!stack.empty()) {
+    const TIndex index = stack.back();
+    stack.pop_back();
+    if (needed[index]) {
+      continue;
+    }
+    needed[index] = true;
+    if (justifications[index].kind == Kind::MODUS_PONENS) {
+      stack.push_back(justifications[index].implication);
+      stack.push_back(justifications[index].premise);
+    }
+  }
+
+  std::vector<Rules::TPtr> result;
+  IdSet added;
+  for (TIndex index = 0; index < justifications.size(); index++) {
+    if (needed[index] && added.Insert(*justifications[index].expr)) {
+      result.push_back(justifications[index].expr);
+    }
+  }
+  return result;
+}
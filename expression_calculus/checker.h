@@ -0,0 +1,148 @@
+#pragma once
+
+#include "expression.h"
+#include "id_map.h"
+#include "proof_stats.h"
+#include "rules.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Checks a hilbert-style proof line by line (each line is justified as soon as
+// it is added). Only a compact justification of every line is recorded; the
+// natural deduction trees are built on demand, just for the lines reachable
+// from the requested one. Only the expressions are stored, not the lines
+// themselves, so the proof can be streamed through the checker. The
+// expressions are looked up by their ids (see `IdMap`), so they all must come
+// from the same `Semantic::Arena`
+class ProofChecker {
+public:
+  // With `shallowest` every expression keeps the shallowest of the
+  // justifications found for it (a hypothesis or an axiom, else the modus
+  // ponens of the least depth) instead of the one the classic conversion
+  // expects, which is what `Minimize` needs. The classification is timed in
+  // `stats` if they are given (they must outlive the checker)
+  ProofChecker(
+      const std::vector<Rules::TPtr>& hypothesesList,
+      bool shallowest = false,
+      ProofStats* proofStats = nullptr) :
+    preferShallowest{shallowest},
+    stats{proofStats}
+  {
+    for (const auto& hypothesis : hypothesesList) {
+      hypotheses.Insert(*hypothesis);
+    }
+  }
+
+  // The part of the justification of a line that doesn't depend on the other
+  // lines of the proof (so it can be found for many lines in parallel)
+  struct Classification {
+    bool hypothesis = false;
+    std::size_t scheme = Rules::NOT_AN_AXIOM;
+  };
+
+  // Thread-safe
+  Classification Classify(const Rules::TPtr& line) const;
+
+  // Returns false if the line is neither a hypothesis, nor an axiom, nor can
+  // it be obtained via modus ponens from the lines added before
+  bool AddLine(const Rules::TPtr& line) {
+    return AddLine(line, Classify(line));
+  }
+
+  // Precondition: `classification` == Classify(line)
+  bool AddLine(const Rules::TPtr& line, const Classification& classification);
+
+  // Builds the trees of the justifications `expr` depends on (the ones that
+  // were built before are reused)
+  // Precondition: `expr` was added to the proof
+  const Rules::NaturalNode* GetTree(const Rules::TPtr& expr);
+
+  // How the lines added so far were justified and the sizes of the tables
+  struct Counters {
+    std::size_t hypotheses = 0;
+    std::size_t axioms = 0;
+    std::size_t modusPonens = 0;
+    std::size_t repeated = 0;  // skipped in the `shallowest` mode
+    std::size_t precalcMP = 0;
+    std::size_t inNeedOfLhs = 0;
+  };
+
+  Counters GetCounters() const {
+    Counters result = counters;
+    result.precalcMP = precalcMP.Size();
+    result.inNeedOfLhs = inNeedOfLhs.Size();
+    return result;
+  }
+
+  // The lines `expr` depends on (each distinct one once, `expr` last) in an
+  // order they can be checked in, i.e. the minimal proof of `expr`
+  // Precondition: `expr` was added to the proof of a `shallowest` checker
+  std::vector<Rules::TPtr> Minimize(const Rules::TPtr& expr) const;
+
+private:
+  using TIndex = std::uint32_t;
+
+  // How an expression is proven. A repeated line gets a new justification (of
+  // the expression's latest proof) while the ones that refer to the previous
+  // proof stay intact, so the trees are the same as if they were built along
+  // with the checking
+  struct Justification {
+    enum class Kind : std::uint8_t {
+      HYPOTHESIS,
+      AXIOM,
+      MODUS_PONENS,
+    };
+
+    Rules::TPtr expr;
+    Kind kind;
+    std::uint8_t scheme = 0;  // of an axiom
+    TIndex implication = 0;  // of modus ponens: the justifications of
+    TIndex premise = 0;      // `a -> expr` and `a`
+    TIndex depth = 0;  // the longest chain of modus ponens
+  };
+
+  TIndex AddJustification(Justification justification) {
+    assert(justifications.size() < std::numeric_limits<TIndex>::max());
+    justifications.push_back(std::move(justification));
+    return justifications.size() - 1;
+  }
+
+  // Records that `b` is given by modus ponens from the justifications
+  // `implication` and `premise`
+  void AddModusPonens(const Rules::TPtr& b, TIndex implication, TIndex premise);
+
+  IdSet hypotheses;
+  bool preferShallowest;
+  ProofStats* stats;
+  Counters counters;
+  std::vector<Justification> justifications;
+  std::vector<const Rules::NaturalNode*> trees;  // Built trees, by the index
+                                                 // of the justification
+  Rules::NodeArena nodes;  // Storage of the trees
+  IdMap<TIndex> precalcMP;  // Precalculated expressions that can be proven
+                            // via Modus Ponens
+  IdMap<TIndex> encountered;  // Expressions that were already encountered and
+                              // proved
+
+  static constexpr TIndex NO_LINE = std::numeric_limits<TIndex>::max();
+
+  // A line `a -> b` that waits for `a`, an element of a list in `waiting`
+  struct Waiting {
+    const Semantic::Expression* implication;
+    TIndex next = NO_LINE;
+  };
+
+  struct WaitingList {
+    TIndex head = NO_LINE;
+    TIndex tail = NO_LINE;
+  };
+
+  std::vector<Waiting> waiting;  // All the lists of `inNeedOfLhs`, linked
+  IdMap<WaitingList> inNeedOfLhs;  // Map of following format:
+                                   // a -> {a -> b_1, ..., a -> b_m)
+};
@@ -1,84 +1,108 @@
 #include "expression.h"
 
-namespace {
+#include <algorithm>
 
-  // The start of expression
-void RegularToPrefixNotation(const Regular::Expression* expr, std::string& result) {
-  switch (expr->GetType()) {
-    case ExpressionType::BOTTOM:
-      result.append("_|_");
-      break;
-    case ExpressionType::VARIABLE:
-      result.append(Regular::Variable::fromExpression(expr)->name);
-      break;
-    case ExpressionType::CONJUNCTION:
-      result.append("& ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::CONJUNCTION>::fromExpression(expr)->left.get(), result);
-      result.append(" ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::CONJUNCTION>::fromExpression(expr)->right.get(), result);
-      break;
-    case ExpressionType::DISJUNCTION:
-      result.append("| ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::DISJUNCTION>::fromExpression(expr)->left.get(), result);
-      result.append(" ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::DISJUNCTION>::fromExpression(expr)->right.get(), result);
-      break;
-    case ExpressionType::IMPLICATION:
-      result.append("-> ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::IMPLICATION>::fromExpression(expr)->left.get(), result);
-      result.append(" ");
-      RegularToPrefixNotation(Regular::BinaryOperation<ExpressionType::IMPLICATION>::fromExpression(expr)->right.get(), result);
-      break;
-  }
-}
+namespace {
 
 std::string RegularToPrefixNotation(const Regular::Expression* expr) {
   std::string result;
-  RegularToPrefixNotation(expr, result);
+  // either an expression to write or the text between its operands
+  struct Item {
+    const Regular::Expression* expr;
+    std::string_view text;
+  };
+  std::vector<Item> stack{{expr, {}}};
+  while (!stack.empty()) {
+    auto [top, text] = stack.back();
+    stack.pop_back();
+    if (top == nullptr) {
+      result.append(text);
+      continue;
+    }
+    switch (top->GetType()) {
+      case ExpressionType::BOTTOM:
+        result.append("_|_");
+        break;
+      case ExpressionType::VARIABLE:
+        result.append(Regular::Variable::fromExpression(top)->name);
+        break;
+      case ExpressionType::CONJUNCTION:
+      case ExpressionType::DISJUNCTION:
+      case ExpressionType::IMPLICATION: {
+        constexpr std::string_view prefixes[] = {"& ", "| ", "-> "};
+        result.append(prefixes[static_cast<std::size_t>(top->GetType())]);
+        auto bop = static_cast<const Regular::BinaryOperationBase*>(top);
+        stack.push_back({bop->right.get(), {}});
+        stack.push_back({nullptr, " "});
+        stack.push_back({bop->left.get(), {}});
+        break;
+      }
+    }
+  }
   return result;
 }
 
-std::shared_ptr<Semantic::Expression> RegularToSemantic(const Regular::Expression* expr, std::string_view remains) {
-  std::shared_ptr<Semantic::Expression> resultingExpression;
-  switch (expr->GetType()) {
-    case ExpressionType::BOTTOM:
-      assert(remains.find("_|_") == 0);
-      resultingExpression = std::make_shared<Semantic::Bottom>(remains.substr(0, 3));
-      break;
-    case ExpressionType::VARIABLE:
-      resultingExpression = std::make_shared<Semantic::Variable>(remains.substr(0, Regular::Variable::fromExpression(expr)->name.size()));
-      break;
-    case ExpressionType::CONJUNCTION: {
-      assert(remains.find("& ") == 0);
-      auto lhs = RegularToSemantic(Regular::Conjunction::fromExpression(expr)->left.get(), remains.substr(2));
-      assert(remains[2 + lhs->Len()] == ' ');
-      auto rhs = RegularToSemantic(Regular::Conjunction::fromExpression(expr)->right.get(), remains.substr(3 + lhs->Len()));
-      resultingExpression = std::make_shared<Semantic::Conjunction>(remains.substr(0, 3 + lhs->Len() + rhs->Len()), std::move(lhs), std::move(rhs));
-      break;
-    }
-    case ExpressionType::DISJUNCTION: {
-      assert(remains.find("| ") == 0);
-      auto lhs = RegularToSemantic(Regular::Disjunction::fromExpression(expr)->left.get(), remains.substr(2));
-      assert(remains[2 + lhs->Len()] == ' ');
-      auto rhs = RegularToSemantic(Regular::Disjunction::fromExpression(expr)->right.get(), remains.substr(3 + lhs->Len()));
-      resultingExpression = std::make_shared<Semantic::Disjunction>(remains.substr(0, 3 + lhs->Len() + rhs->Len()), std::move(lhs), std::move(rhs));
-      break;
+std::shared_ptr<Semantic::Expression> RegularToSemantic(const Regular::Expression* expr, Semantic::Arena& arena) {
+  // post-order: an operation is interned when both its operands are on
+  // `results`
+  std::vector<std::pair<const Regular::Expression*, bool>> stack{{expr, false}};
+  std::vector<std::shared_ptr<Semantic::Expression>> results;
+  while (!stack.empty()) {
+    auto [top, operandsDone] = stack.back();
+    stack.pop_back();
+    switch (top->GetType()) {
+      case ExpressionType::BOTTOM:
+        results.push_back(arena.MakeBottom());
+        break;
+      case ExpressionType::VARIABLE:
+        results.push_back(arena.MakeVariable(Regular::Variable::fromExpression(top)->name));
+        break;
+      case ExpressionType::CONJUNCTION:
+      case ExpressionType::DISJUNCTION:
+      case ExpressionType::IMPLICATION: {
+        if (!operandsDone) {
+          auto bop = static_cast<const Regular::BinaryOperationBase*>(top);
+          stack.emplace_back(top, true);
+          stack.emplace_back(bop->right.get(), false);
+          stack.emplace_back(bop->left.get(), false);
+          break;
+        }
+        auto rhs = std::move(results.back());
+        results.pop_back();
+        auto lhs = std::move(results.back());
+        results.pop_back();
+        results.push_back(arena.MakeBinary(top->GetType(), lhs, rhs));
+        break;
+      }
     }
-    case ExpressionType::IMPLICATION:
-      assert(remains.find("-> ") == 0);
-      auto lhs = RegularToSemantic(Regular::Implication::fromExpression(expr)->left.get(), remains.substr(3));
-      assert(remains[3 + lhs->Len()] == ' ');
-      auto rhs = RegularToSemantic(Regular::Implication::fromExpression(expr)->right.get(), remains.substr(4 + lhs->Len()));
-      resultingExpression = std::make_shared<Semantic::Implication>(remains.substr(0, 4 + lhs->Len() + rhs->Len()), std::move(lhs), std::move(rhs));
-      break;
   }
-  return resultingExpression;
+  assert(results.size() == 1);
+  return results.back();
 }
 
 } // namespace
 
 namespace Regular {
 
+BinaryOperationBase::~BinaryOperationBase() {
+  if (!left && !right) {
+    return;
+  }
+  std::vector<std::unique_ptr<Expression>> pending;
+  pending.push_back(std::move(left));
+  pending.push_back(std::move(right));
+  while (!pending.empty()) {
+    auto expr = std::move(pending.back());
+    pending.pop_back();
+    if (expr && expr->GetType() != ExpressionType::BOTTOM && expr->GetType() != ExpressionType::VARIABLE) {
+      // detach the operands, so `expr` is destroyed without recursion
+      auto bop = static_cast<BinaryOperationBase*>(expr.get());
+      pending.push_back(std::move(bop->left));
+      pending.push_back(std::move(bop->right));
+    }
+  }
+}
+
 inline bool operator==(const Expression& lhs, const Expression& rhs) {
   if (lhs.GetType() != rhs.GetType()) {
     return false;
@@ -113,18 +137,134 @@ std::string ToString(const Expression* expr) {
 
 namespace Semantic {
 
-OwningExpression::OwningExpression(const Regular::Expression* expr) : expressionString{RegularToPrefixNotation(expr)} {
-  // It is important that `expressionString` is not modified and that it will
-  // outlive every node in AST
-  root = RegularToSemantic(expr, expressionString);
+Arena::Arena() :
+  nextId{0},
+  bottom{std::make_shared<Bottom>(nextId++)}
+{}
+
+Arena::~Arena() {
+  Clear();
 }
 
+void Arena::Clear() {
+  // Destroy the nodes from the newest to the oldest: a parent is always created
+  // after its children (so it has a greater id), so the children are still
+  // owned by the arena by the time their parent goes away (and no long chains
+  // of destructors are triggered)
+  std::vector<std::shared_ptr<Expression>> nodes;
+  std::size_t count = 0;
+  for (const auto& shard : shards) {
+    count += shard.variables.size() + shard.binaries.size();
+  }
+  nodes.reserve(count);
+  for (auto& shard : shards) {
+    for (auto& [name, variable] : shard.variables) {
+      nodes.push_back(std::move(variable));
+    }
+    for (auto& [key, binary] : shard.binaries) {
+      nodes.push_back(std::move(binary));
+    }
+    // (the tables are replaced, so that their buckets are freed as well)
+    decltype(shard.variables){}.swap(shard.variables);
+    decltype(shard.binaries){}.swap(shard.binaries);
+  }
+  std::sort(nodes.begin(), nodes.end(), [] (const auto& lhs, const auto& rhs) {
+    return lhs->id < rhs->id;
+  });
+  while (!nodes.empty()) {
+    nodes.pop_back();
+  }
+}
+
+Arena& Arena::Global() {
+  static Arena arena;
+  return arena;
+}
+
+std::shared_ptr<Expression> Arena::MakeVariable(std::string_view name) {
+  auto& shard = GetShard(HashVariable(name));
+  std::lock_guard lock{shard.mutex};
+  if (auto it = shard.variables.find(name); it != shard.variables.end()) {
+    return it->second;
+  }
+  auto variable = std::make_shared<Variable>(nextId++, name);
+  shard.variables.emplace(variable->GetName(), variable);
+  return variable;
+}
+
+std::shared_ptr<Expression> Arena::MakeBinary(
+    ExpressionType type,
+    const std::shared_ptr<Expression>& lhs,
+    const std::shared_ptr<Expression>& rhs) {
+  BinaryKey key{type, lhs->id, rhs->id, HashBinary(type, lhs->memoizedHash, rhs->memoizedHash)};
+  auto& shard = GetShard(key.hash);
+  std::lock_guard lock{shard.mutex};
+  if (auto it = shard.binaries.find(key); it != shard.binaries.end()) {
+    return it->second;
+  }
+  std::shared_ptr<Expression> result;
+  switch (type) {
+    case ExpressionType::CONJUNCTION:
+      result = std::make_shared<Conjunction>(nextId++, lhs, rhs);
+      break;
+    case ExpressionType::DISJUNCTION:
+      result = std::make_shared<Disjunction>(nextId++, lhs, rhs);
+      break;
+    case ExpressionType::IMPLICATION:
+      result = std::make_shared<Implication>(nextId++, lhs, rhs);
+      break;
+    default:
+      assert(false && "Not a binary operation");
+  }
+  shard.binaries.emplace(key, result);
+  return result;
+}
+
+std::size_t Arena::BinariesCount() const {
+  std::size_t count = 0;
+  for (const auto& shard : shards) {
+    std::lock_guard lock{shard.mutex};
+    count += shard.binaries.size();
+  }
+  return count;
+}
+
+Arena::HashReport Arena::CollectHashReport() const {
+  HashReport report;
+  std::vector<std::size_t> hashes{bottom->memoizedHash};
+  for (const auto& shard : shards) {
+    std::lock_guard lock{shard.mutex};
+    for (const auto& [name, variable] : shard.variables) {
+      hashes.push_back(variable->memoizedHash);
+    }
+    for (const auto& [key, binary] : shard.binaries) {
+      hashes.push_back(binary->memoizedHash);
+    }
+    report.buckets += shard.binaries.bucket_count();
+    for (std::size_t i = 0; i < shard.binaries.bucket_count(); i++) {
+      if (auto size = shard.binaries.bucket_size(i); size > 0) {
+        report.usedBuckets++;
+        report.longestChain = std::max(report.longestChain, size);
+      }
+    }
+  }
+  report.expressions = hashes.size();
+  std::sort(hashes.begin(), hashes.end());
+  report.distinctHashes = std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+  return report;
+}
+
+OwningExpression::OwningExpression(const Regular::Expression* expr) :
+  expressionString{RegularToPrefixNotation(expr)},
+  root{RegularToSemantic(expr, Arena::Global())}
+{}
+
 bool operator==(const Semantic::Expression& lhs, const Semantic::Expression& rhs) {
-  return lhs.expressionView == rhs.expressionView;
+  return lhs.id == rhs.id;
 }
 
 bool operator==(const OwningExpression& lhs, const OwningExpression& rhs) {
-  return lhs.expressionString == rhs.expressionString;
+  return *lhs.root == *rhs.root;
 }
 
 } // nnamespace Semantic
@@ -1,10 +1,16 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <cassert>
+#include <cstdint>
 #include <functional>
+#include <unordered_map>
+#include <vector>
 
 // No negation since it is interpreted as (a -> _|_)
 
@@ -16,6 +22,24 @@ enum class ExpressionType : std::size_t {
   BOTTOM
 };
 
+// A variable name is a capital letter followed by capital letters, digits and
+// apostrophes
+inline bool IsVariableNameChar(char c) {
+  return ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '\'';
+}
+
+inline bool IsVariableName(std::string_view name) {
+  if (name.empty() || !('A' <= name[0] && name[0] <= 'Z')) {
+    return false;
+  }
+  for (char c : name) {
+    if (!IsVariableNameChar(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 namespace Regular {
 
 struct Expression {
@@ -29,6 +53,10 @@ struct BinaryOperationBase : Expression {
     left{std::move(lhs)}, right{std::move(rhs)}
   {}
 
+  // Releases the subtrees with an explicit stack (the default destructor would
+  // recurse once per nesting level)
+  ~BinaryOperationBase() override;
+
   std::unique_ptr<Expression> left;
   std::unique_ptr<Expression> right;
 };
@@ -108,28 +136,68 @@ std::string ToString(const Expression* expr);
 
 namespace Semantic {
 
-struct Expression : Regular::Expression {
-  Expression(std::string_view view) :
-    expressionView{view},
-    memoizedHash{std::hash<std::string_view>{}(view)}
-  {}
+/*******************************************************************************
+*                             Structural hashing                              *
+*******************************************************************************/
+
+// The hash of an expression is computed from its type and the hashes of its
+// children (or the name for a variable), so it costs O(1) per node and doesn't
+// depend on the order in which the expressions were interned
+
+// splitmix64 finalizer: every input bit affects every output bit
+constexpr std::uint64_t MixHash(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
 
-  std::size_t Len() const {
-    return expressionView.size();
-  }
+constexpr std::uint64_t TypeSeed(ExpressionType type) {
+  return (static_cast<std::uint64_t>(type) + 1) * 0x9e3779b97f4a7c15ULL;
+}
 
-  std::string_view GetView() const {
-    return expressionView;
+constexpr std::uint64_t HashBottom() {
+  return MixHash(TypeSeed(ExpressionType::BOTTOM));
+}
+
+constexpr std::uint64_t HashVariable(std::string_view name) {
+  // FNV-1a (unlike std::hash, it is the same for every standard library)
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
   }
+  return MixHash(hash ^ TypeSeed(ExpressionType::VARIABLE));
+}
+
+constexpr std::uint64_t HashBinary(ExpressionType type, std::uint64_t lhsHash, std::uint64_t rhsHash) {
+  // the left hash is mixed before the right one is added, so `a -> b` and
+  // `b -> a` get different hashes
+  return MixHash(MixHash(TypeSeed(type) ^ lhsHash) + rhsHash);
+}
+
+/*******************************************************************************
+*                                 Expressions                                 *
+*******************************************************************************/
+
+struct Expression : Regular::Expression {
+  Expression(std::size_t expressionId, std::size_t hash) :
+    id{expressionId},
+    memoizedHash{hash}
+  {}
 
   virtual ~Expression() = default;
 
-  std::string_view expressionView;
-  std::size_t memoizedHash;
+  std::size_t id;  // Expressions are interned (see `Arena`), so equal
+                   // expressions have equal ids and vice versa
+  std::size_t memoizedHash;  // Structural hash (see `HashBinary`)
 };
 
 struct Bottom : Expression {
-  Bottom(std::string_view view) : Expression{view} {}
+  static constexpr ExpressionType TYPE = ExpressionType::BOTTOM;
+
+  Bottom(std::size_t expressionId) : Expression{expressionId, HashBottom()} {}
 
   ExpressionType GetType() const final {
     return ExpressionType::BOTTOM;
@@ -137,23 +205,32 @@ struct Bottom : Expression {
 };
 
 struct Variable : Expression {
-  Variable(std::string_view view) : Expression{view} {
-    // TODO: assert that the view is a valid variable name
+  static constexpr ExpressionType TYPE = ExpressionType::VARIABLE;
+
+  Variable(std::size_t expressionId, std::string_view variableName) :
+    Expression{expressionId, HashVariable(variableName)},
+    name{variableName}
+  {
+    assert(IsVariableName(variableName));
   }
 
-  std::string_view GetName() {
-    return this->expressionView;
+  std::string_view GetName() const {
+    return name;
   }
 
   ExpressionType GetType() const final {
     return ExpressionType::VARIABLE;
   }
+
+  std::string name;
 };
 
 template<ExpressionType EXPRESSION_TYPE>
 struct BinaryOperation : Expression {
-  BinaryOperation(std::string_view view, const std::shared_ptr<Expression>& lhs, const std::shared_ptr<Expression>& rhs) :
-    Expression{view},
+  static constexpr ExpressionType TYPE = EXPRESSION_TYPE;
+
+  BinaryOperation(std::size_t expressionId, const std::shared_ptr<Expression>& lhs, const std::shared_ptr<Expression>& rhs) :
+    Expression{expressionId, HashBinary(EXPRESSION_TYPE, lhs->memoizedHash, rhs->memoizedHash)},
     left{lhs},
     right{rhs}
   {}
@@ -170,23 +247,125 @@ using Conjunction = BinaryOperation<ExpressionType::CONJUNCTION>;
 using Disjunction = BinaryOperation<ExpressionType::DISJUNCTION>;
 using Implication = BinaryOperation<ExpressionType::IMPLICATION>;
 
+// Hash-consing storage of expressions: every distinct (sub)expression is
+// created only once and lives until the arena is destroyed. Two expressions
+// made by the same arena are equal iff they are the same node (iff their ids
+// are equal), so there is no need to compare the trees themselves.
+//
+// The arena is thread-safe: the interning tables are split into shards (by the
+// structural hash) with a mutex per shard, so lines can be parsed in parallel.
+class Arena {
+public:
+  Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena();
+
+  // The arena that is used by the parsers and the rules
+  static Arena& Global();
+
+  std::shared_ptr<Expression> MakeBottom() const {
+    return bottom;
+  }
+
+  std::shared_ptr<Expression> MakeVariable(std::string_view name);
+
+  std::shared_ptr<Expression> MakeBinary(
+      ExpressionType type,
+      const std::shared_ptr<Expression>& lhs,
+      const std::shared_ptr<Expression>& rhs);
+
+  // The number of the ids given out (the expressions dropped by `Clear` are
+  // counted as well)
+  std::size_t Size() const {
+    return nextId.load(std::memory_order_relaxed);
+  }
+
+  // Drops all the interned expressions but `_|_` (those still referenced
+  // elsewhere live on, but are not interned anymore). The ids are not reused,
+  // so the ids kept by the caches can't match another expression. Must not be
+  // called while the expressions of the arena are in use
+  void Clear();
+
+  struct HashReport {
+    std::size_t expressions = 0;
+    std::size_t distinctHashes = 0;  // distinct values of `memoizedHash`
+    std::size_t buckets = 0;  // of the tables that intern binary operations
+    std::size_t usedBuckets = 0;
+    std::size_t longestChain = 0;
+
+    // the share of the expressions whose hash is equal to the hash of some
+    // other (different) expression
+    double CollisionRate() const {
+      return expressions == 0 ? 0. : static_cast<double>(expressions - distinctHashes) / expressions;
+    }
+
+    // the share of the interned binary operations that share a bucket with
+    // some other operation
+    double BucketCollisionRate(std::size_t binaries) const {
+      return binaries == 0 ? 0. : static_cast<double>(binaries - usedBuckets) / binaries;
+    }
+  };
+
+  // Takes O(n log n), meant for diagnostics only
+  HashReport CollectHashReport() const;
+
+  std::size_t BinariesCount() const;
+
+private:
+  struct BinaryKey {
+    ExpressionType type;
+    std::size_t lhs;
+    std::size_t rhs;
+    std::size_t hash;  // the structural hash of the node with such a key
+
+    bool operator==(const BinaryKey& other) const {
+      return type == other.type && lhs == other.lhs && rhs == other.rhs;
+    }
+  };
+
+  struct BinaryKeyHasher {
+    std::size_t operator()(const BinaryKey& key) const {
+      return key.hash;
+    }
+  };
+
+  struct VariableHasher {
+    std::size_t operator()(std::string_view name) const {
+      return HashVariable(name);
+    }
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string_view, std::shared_ptr<Expression>, VariableHasher> variables;  // the keys
+                                                                                                 // refer to
+                                                                                                 // `Variable::name`
+    std::unordered_map<BinaryKey, std::shared_ptr<Expression>, BinaryKeyHasher> binaries;
+  };
+
+  static constexpr std::size_t SHARDS_BITS = 6;
+
+  Shard& GetShard(std::size_t hash) {
+    // the lower bits are used by the buckets of the shard's tables
+    return shards[hash >> (64 - SHARDS_BITS)];
+  }
+
+  std::atomic<std::size_t> nextId;
+  std::shared_ptr<Expression> bottom;
+  std::array<Shard, std::size_t{1} << SHARDS_BITS> shards;
+};
+
+// Kept for the line-by-line parsing interface: the prefix notation of the
+// parsed line together with the root of its (interned) tree
 struct OwningExpression {
   OwningExpression(const Regular::Expression* expr);
 
   OwningExpression& operator=(const OwningExpression&) = delete;
   OwningExpression& operator=(OwningExpression&&) = delete;
 
-  ~OwningExpression() {
-    // The default destruction order is correct though I wouldn't rely on it.
-    // The reason for that is AST holding string_views refering to
-    // `expressionString` i.e. the refered string should remain intact until the
-    // refering views are destroyed (since std::basic_string_view is not
-    // trivially destructible (at least in c++17))
-    assert(root.use_count() == 1);  // OwningExpression should be the last owner
-                                    // of `root` and all of its descendants
-    root.reset();
-  }
-
   std::string expressionString;
   std::shared_ptr<Expression> root;
 };
@@ -195,14 +374,19 @@ bool operator==(const Expression& lhs, const Expression& rhs);
 
 bool operator==(const OwningExpression& lhs, const OwningExpression& rhs);
 
+// Downcasts via the type tag (no RTTI)
 template<typename TComp>
 const TComp* GetComponent(const Expression* expr) {
-  return dynamic_cast<const TComp*>(expr);
+  if constexpr (std::is_same_v<TComp, Expression>) {
+    return expr;
+  } else {
+    return expr != nullptr && expr->GetType() == TComp::TYPE ? static_cast<const TComp*>(expr) : nullptr;
+  }
 }
 
 template<typename TComp, typename TExpr, typename TField, typename ...TRest, typename ...TFields>
 const TComp* GetComponent(const Expression* expr, TField TExpr::* fieldPtr, TFields TRest::*... rest) {
-  auto downcastedExpr = dynamic_cast<const TExpr*>(expr);
+  auto downcastedExpr = GetComponent<TExpr>(expr);
   if (downcastedExpr == nullptr) {
     return nullptr;
   }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "expression.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash table (linear probing) from interned expressions to
+// `TValue`. An expression is keyed by its id (see `Semantic::Arena`), so all
+// the keys must come from the same arena: a lookup neither dereferences the
+// expressions nor compares them, and the slots are stored in a single array,
+// so it touches a cache line or two instead of chasing the pointers of a
+// bucket list. Elements are erased only by `Retain`.
+template<typename TValue>
+class IdMap {
+public:
+  IdMap() : slots(MIN_CAPACITY) {}
+
+  const TValue* Find(const Semantic::Expression& expr) const {
+    const auto& slot = slots[SlotOf(expr.id)];
+    return slot.id == EMPTY ? nullptr : &slot.value;
+  }
+
+  TValue* Find(const Semantic::Expression& expr) {
+    auto& slot = slots[SlotOf(expr.id)];
+    return slot.id == EMPTY ? nullptr : &slot.value;
+  }
+
+  bool Contains(const Semantic::Expression& expr) const {
+    return Find(expr) != nullptr;
+  }
+
+  // Inserts a value-initialized `TValue` if there is no `expr` yet
+  TValue& operator[](const Semantic::Expression& expr) {
+    std::size_t index = SlotOf(expr.id);
+    if (slots[index].id == EMPTY) {
+      if (2 * (size + 1) > slots.size()) {
+        Grow();
+        index = SlotOf(expr.id);
+      }
+      slots[index].id = expr.id;
+      size++;
+    }
+    return slots[index].value;
+  }
+
+  std::size_t Size() const {
+    return size;
+  }
+
+  std::size_t MemoryUsage() const {
+    return slots.capacity() * sizeof(Slot);
+  }
+
+  // Keeps only the elements whose values satisfy `keep` and shrinks the
+  // table to fit them. Takes O(capacity)
+  template<typename TPredicate>
+  void Retain(TPredicate keep) {
+    std::size_t kept = 0;
+    for (const auto& slot : slots) {
+      kept += slot.id != EMPTY && keep(slot.value);
+    }
+    std::size_t capacity = MIN_CAPACITY;
+    while (2 * kept > capacity) {
+      capacity *= 2;
+    }
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    for (auto& slot : old) {
+      if (slot.id != EMPTY && keep(slot.value)) {
+        slots[SlotOf(slot.id)] = std::move(slot);
+      }
+    }
+    size = kept;
+  }
+
+private:
+  static constexpr std::size_t EMPTY = SIZE_MAX;
+  static constexpr std::size_t MIN_CAPACITY = 16;
+
+  struct Slot {
+    std::size_t id = EMPTY;
+    TValue value{};
+  };
+
+  // The slot of `id` or the empty slot where it would be inserted (the table
+  // is at most half full, so there is one)
+  std::size_t SlotOf(std::size_t id) const {
+    assert(id != EMPTY);
+    const std::size_t mask = slots.size() - 1;
+    std::size_t index = Semantic::MixHash(id) & mask;
+    while (slots[index].id != id && slots[index].id != EMPTY) {
+      index = (index + 1) & mask;
+    }
+    return index;
+  }
+
+  void Grow() {
+    std::vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    for (auto& slot : old) {
+      if (slot.id != EMPTY) {
+        slots[SlotOf(slot.id)] = std::move(slot);
+      }
+    }
+  }
+
+  std::vector<Slot> slots;  // the size is a power of two
+  std::size_t size = 0;
+};
+
+// A set of interned expressions, see `IdMap`
+class IdSet {
+public:
+  // Returns false if `expr` is already there
+  bool Insert(const Semantic::Expression& expr) {
+    const std::size_t before = map.Size();
+    map[expr];
+    return map.Size() > before;
+  }
+
+  bool Contains(const Semantic::Expression& expr) const {
+    return map.Contains(expr);
+  }
+
+  std::size_t Size() const {
+    return map.Size();
+  }
+
+private:
+  struct Present {};
+
+  IdMap<Present> map;
+};
@@ -31,58 +31,42 @@ struct Tokenizer {
 public:
   using Token = std::pair<TokenType, std::string_view>;
 
+  // Tag for the constructor that doesn't copy the line
+  struct NonOwning {};
+
   Tokenizer(std::string line) : currentToken{0}, tokenizedString{std::move(line)} {
-    // tokenization process (same for A and B)
+    Tokenize(tokenizedString);
+  }
+
+  // The tokens refer to `line` itself, so it must outlive the tokenizer
+  Tokenizer(std::string_view line, NonOwning) : currentToken{0} {
+    Tokenize(line);
+  }
+
+  // Returns the token `v` starts with (`v` must be non-empty and start with a
+  // non-whitespace character). The view of the token refers to `v`
+  static Token MatchToken(std::string_view v) {
     using namespace std::literals;  // for ""sv
-    std::string_view v{tokenizedString.data(), tokenizedString.size()};
-    const auto tryMatchPrefix = [] (std::string_view remains) -> std::optional<Token> {
-      static constexpr std::initializer_list<Token> simpleTokens = {
-        {TokenType::TURNSTILE, "|-"sv},
-        {TokenType::ARROW, "->"sv},
-        {TokenType::AMPERSAND, "&"sv},
-        {TokenType::BAR, "|"sv},
-        {TokenType::EXCLAMATION, "!"sv},
-        {TokenType::LPAREN, "("sv},
-        {TokenType::RPAREN, ")"sv},
-        {TokenType::COMMA, ","sv},
-      };
-      for (const auto& [tokenType, tok]: simpleTokens) {
-        if (remains.substr(0, tok.size()) == tok) {
-          remains.remove_prefix(tok.size());
-          return std::make_pair(tokenType, tok);
-        }
-      }
-      return std::nullopt;
+    static constexpr std::initializer_list<Token> simpleTokens = {
+      {TokenType::TURNSTILE, "|-"sv},
+      {TokenType::ARROW, "->"sv},
+      {TokenType::AMPERSAND, "&"sv},
+      {TokenType::BAR, "|"sv},
+      {TokenType::EXCLAMATION, "!"sv},
+      {TokenType::LPAREN, "("sv},
+      {TokenType::RPAREN, ")"sv},
+      {TokenType::COMMA, ","sv},
     };
-    while (true) {
-      // trim whitespace characters from the beginning (if they are present)
-      auto pos = v.find_first_not_of(" \t\r\f\v");
-      if (pos != std::string_view::npos) {
-        v.remove_prefix(pos);
-      } else {
-        break;
-      }
-      if (v.empty()) {
-        break;
-      }
-      // now try to find one of tokens (varible, |-, ->, |, &, !, left-paren,
-      // right-paren, comma)
-      // TODO: Improve the design (lambda mutates the view)
-      if (auto matchedToken = tryMatchPrefix(v)) {
-        auto [tokenType, tok] = *matchedToken;
-        v.remove_prefix(tok.size());
-        tokens.emplace_back(tokenType, tok);
-      } else {
-        // we have a variable - it is 100% of needed format but we better verify
-        // it with asserts
-        assert('A' <= v[0] && v[0] <= 'Z');
-        auto new_start = std::find_if_not(v.begin(), v.end(), [] (char c) {
-            return ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') || c == '\'';
-        });
-        tokens.emplace_back(TokenType::VARIABLE, v.substr(0, new_start - v.begin()));
-        v.remove_prefix(new_start - v.begin());
+    for (const auto& [tokenType, tok]: simpleTokens) {
+      if (v.substr(0, tok.size()) == tok) {
+        return std::make_pair(tokenType, v.substr(0, tok.size()));
       }
     }
+    // we have a variable - it is 100% of needed format but we better verify
+    // it with asserts
+    assert('A' <= v[0] && v[0] <= 'Z');
+    auto new_start = std::find_if_not(v.begin(), v.end(), IsVariableNameChar);
+    return std::make_pair(TokenType::VARIABLE, v.substr(0, new_start - v.begin()));
   }
 
   Tokenizer& operator=(const Tokenizer&) = delete;
@@ -110,79 +94,197 @@ public:
   }
 
 private:
+  void Tokenize(std::string_view v) {
+    // tokenization process (same for A and B)
+    while (true) {
+      // trim whitespace characters from the beginning (if they are present)
+      auto pos = v.find_first_not_of(" \t\r\f\v");
+      if (pos != std::string_view::npos) {
+        v.remove_prefix(pos);
+      } else {
+        break;
+      }
+      if (v.empty()) {
+        break;
+      }
+      // now try to find one of tokens (varible, |-, ->, |, &, !, left-paren,
+      // right-paren, comma)
+      tokens.emplace_back(MatchToken(v));
+      v.remove_prefix(tokens.back().second.size());
+    }
+  }
+
   std::size_t currentToken;
   std::vector<Token> tokens;
   std::string tokenizedString;
 };
 
 /*******************************************************************************
-*                                   Parser                                    *
+*                             Precedence parsing                              *
 *******************************************************************************/
 
-struct Parser {
-public:
-  Parser(std::string expressionLine) : tokenizer{std::make_unique<Tokenizer>(std::move(expressionLine))} {}
-  Parser(std::unique_ptr<Tokenizer>&& t) : tokenizer{std::move(t)} {}
+// Both parsers accept
+//   E := D ('->' E)?     (implication is right-associative)
+//   D := C ('|' C)*
+//   C := P ('&' P)*
+//   P := '(' E ')' | '!' P | VAR
+// The grammar is parsed with explicit stacks of operands and operators instead
+// of a recursive descent, so the nesting depth of a line is limited only by
+// the memory
 
-  std::unique_ptr<Regular::Expression> ParsePrim() {
-    if (!tokenizer->Peek()) {
-      throw std::runtime_error{"Token expected at the beginning of expression primitive"};
-    }
-    auto [tokenType, token] = *tokenizer->NextToken();
-    switch (tokenType) {
-      case TokenType::LPAREN: {
-        std::unique_ptr<Regular::Expression> expr = ParseExpression();
-        if (auto rparen = tokenizer->NextToken(); !rparen || rparen->first != TokenType::RPAREN) {
-          throw std::runtime_error{std::string{"Closing parenthesis expected, got "} + (rparen ? std::string{rparen->second} : "no tokens")};
-        }
-        return expr;
-      }
-      case TokenType::VARIABLE: {
-        return std::make_unique<Regular::Variable>(std::string{token});
-      }
-      case TokenType::EXCLAMATION: {
-        return std::make_unique<Regular::Implication>(ParsePrim(), std::make_unique<Regular::Bottom>());
-      }
+namespace Detail {
+
+// The operators that wait for their right operands (the binary ones are
+// ordered from the tightest binding)
+enum class PendingOperator {
+  LPAREN,
+  NEGATION,
+  CONJUNCTION,
+  DISJUNCTION,
+  IMPLICATION
+};
+
+struct RegularBuilder {
+  using TNode = std::unique_ptr<Regular::Expression>;
+
+  TNode MakeVariable(std::string_view name) {
+    return std::make_unique<Regular::Variable>(std::string{name});
+  }
+
+  TNode MakeNegation(TNode operand) {
+    return std::make_unique<Regular::Implication>(std::move(operand), std::make_unique<Regular::Bottom>());
+  }
+
+  TNode MakeBinary(ExpressionType type, TNode lhs, TNode rhs) {
+    switch (type) {
+      case ExpressionType::CONJUNCTION:
+        return std::make_unique<Regular::Conjunction>(std::move(lhs), std::move(rhs));
+      case ExpressionType::DISJUNCTION:
+        return std::make_unique<Regular::Disjunction>(std::move(lhs), std::move(rhs));
       default:
-        throw std::runtime_error{"Unexpected token at the start of primary expression"};
+        return std::make_unique<Regular::Implication>(std::move(lhs), std::move(rhs));
     }
   }
+};
 
-  std::unique_ptr<Regular::Expression> ParseConjunctionSequence() {
-    std::unique_ptr<Regular::Expression> result = ParsePrim();
-    while (tokenizer->Peek() && tokenizer->Peek()->first == TokenType::AMPERSAND) {
-      tokenizer->NextToken();
-      result = std::make_unique<Regular::Conjunction>(std::move(result), ParsePrim());
-    }
-    return result;
+struct SemanticBuilder {
+  using TNode = std::shared_ptr<Semantic::Expression>;
+
+  TNode MakeVariable(std::string_view name) {
+    return arena.MakeVariable(name);
   }
 
-  std::unique_ptr<Regular::Expression> ParseDisjunctionSequence() {
-    std::unique_ptr<Regular::Expression> result = ParseConjunctionSequence();
-    while (tokenizer->Peek() && tokenizer->Peek()->first == TokenType::BAR) {
-      tokenizer->NextToken();
-      result = std::make_unique<Regular::Disjunction>(std::move(result), ParsePrim());
-    }
-    return result;
+  TNode MakeNegation(TNode operand) {
+    return arena.MakeBinary(ExpressionType::IMPLICATION, operand, arena.MakeBottom());
   }
 
-  std::unique_ptr<Regular::Expression> ParseExpression() {
-    std::vector<std::unique_ptr<Regular::Expression>> clauses;
-    clauses.emplace_back(ParseDisjunctionSequence());
-    while (tokenizer->Peek() && tokenizer->Peek()->first == TokenType::ARROW) {
-      tokenizer->NextToken();
-      clauses.emplace_back(ParseDisjunctionSequence());
+  TNode MakeBinary(ExpressionType type, TNode lhs, TNode rhs) {
+    return arena.MakeBinary(type, lhs, rhs);
+  }
+
+  Semantic::Arena& arena;
+};
+
+}  // namespace Detail
+
+// Parses the longest expression at the beginning of the tokens of `source`
+// (`std::optional<Token> Peek()`, `void Skip()`); the token that can't
+// continue the expression is left in `source`. The nodes are made by
+// `builder` (see `Detail::RegularBuilder`)
+template<typename TSource, typename TBuilder>
+typename TBuilder::TNode ParseInfix(TSource& source, TBuilder& builder) {
+  using Detail::PendingOperator;
+  std::vector<typename TBuilder::TNode> operands;
+  std::vector<PendingOperator> operators;
+  std::size_t openParens = 0;
+
+  const auto popOperand = [&operands] {
+    auto operand = std::move(operands.back());
+    operands.pop_back();
+    return operand;
+  };
+  // Makes the nodes of the binary operators on the top of the stack that bind
+  // at least as tightly as `weakest`
+  const auto reduce = [&] (PendingOperator weakest) {
+    while (!operators.empty() && operators.back() >= PendingOperator::CONJUNCTION && operators.back() <= weakest) {
+      auto rhs = popOperand();
+      auto lhs = popOperand();
+      constexpr ExpressionType types[] = {ExpressionType::CONJUNCTION, ExpressionType::DISJUNCTION, ExpressionType::IMPLICATION};
+      auto type = types[static_cast<std::size_t>(operators.back()) - static_cast<std::size_t>(PendingOperator::CONJUNCTION)];
+      operators.pop_back();
+      operands.push_back(builder.MakeBinary(type, std::move(lhs), std::move(rhs)));
     }
-    std::unique_ptr<Regular::Expression> result = std::move(clauses.back());
-    clauses.pop_back();
-    std::reverse(clauses.begin(), clauses.end());
-    // I decided not to use std::accumulate (accumulate, not reduce because the
-    // order is important!) because the code becomes less readable and less
-    // predictable
-    for (auto& clause : clauses) {
-      result = std::make_unique<Regular::Implication>(std::move(clause), std::move(result));
+  };
+
+  while (true) {
+    // P is expected: the prefixes of P go to the stack until a variable
+    auto token = source.Peek();
+    if (!token) {
+      throw std::runtime_error{"Token expected at the beginning of expression primitive"};
     }
-    return result;
+    source.Skip();
+    if (token->first == TokenType::LPAREN) {
+      operators.push_back(PendingOperator::LPAREN);
+      openParens++;
+      continue;
+    } else if (token->first == TokenType::EXCLAMATION) {
+      operators.push_back(PendingOperator::NEGATION);
+      continue;
+    } else if (token->first != TokenType::VARIABLE) {
+      throw std::runtime_error{"Unexpected token at the start of primary expression"};
+    }
+    operands.push_back(builder.MakeVariable(token->second));
+
+    // P is complete: negate it, close the parentheses around it and find the
+    // operator after it
+    while (true) {
+      while (!operators.empty() && operators.back() == PendingOperator::NEGATION) {
+        operators.pop_back();
+        operands.push_back(builder.MakeNegation(popOperand()));
+      }
+      auto next = source.Peek();
+      if (next && next->first == TokenType::AMPERSAND) {
+        reduce(PendingOperator::CONJUNCTION);
+        operators.push_back(PendingOperator::CONJUNCTION);
+      } else if (next && next->first == TokenType::BAR) {
+        reduce(PendingOperator::DISJUNCTION);
+        operators.push_back(PendingOperator::DISJUNCTION);
+      } else if (next && next->first == TokenType::ARROW) {
+        reduce(PendingOperator::DISJUNCTION);
+        operators.push_back(PendingOperator::IMPLICATION);
+      } else if (openParens > 0) {
+        if (!next || next->first != TokenType::RPAREN) {
+          throw std::runtime_error{std::string{"Closing parenthesis expected, got "} + (next ? std::string{next->second} : "no tokens")};
+        }
+        source.Skip();
+        reduce(PendingOperator::IMPLICATION);
+        operators.pop_back();
+        openParens--;
+        continue;
+      } else {
+        reduce(PendingOperator::IMPLICATION);
+        assert(operands.size() == 1 && operators.empty());
+        return popOperand();
+      }
+      source.Skip();
+      break;
+    }
+  }
+}
+
+/*******************************************************************************
+*                                   Parser                                    *
+*******************************************************************************/
+
+struct Parser {
+public:
+  Parser(std::string expressionLine) : tokenizer{std::make_unique<Tokenizer>(std::move(expressionLine))} {}
+  Parser(std::unique_ptr<Tokenizer>&& t) : tokenizer{std::move(t)} {}
+
+  std::unique_ptr<Regular::Expression> ParseExpression() {
+    Source source{*tokenizer};
+    Detail::RegularBuilder builder;
+    return ParseInfix(source, builder);
   }
 
   std::unique_ptr<Semantic::OwningExpression> ParseOwningExpression() {
@@ -190,6 +292,10 @@ public:
     return std::make_unique<Semantic::OwningExpression>(reg.get());
   }
 
+  std::shared_ptr<Semantic::Expression> ParseSemantic() {
+    return ParseOwningExpression()->root;
+  }
+
   bool ParseToken(TokenType tokenType) {
     if (tokenizer->Peek() && tokenizer->Peek()->first == tokenType) {
       tokenizer->NextToken();
@@ -219,5 +325,96 @@ public:
   }
 
 private:
+  struct Source {
+    std::optional<Tokenizer::Token> Peek() {
+      return tokenizer.Peek();
+    }
+
+    void Skip() {
+      tokenizer.NextToken();
+    }
+
+    Tokenizer& tokenizer;
+  };
+
   std::unique_ptr<Tokenizer> tokenizer;
 };
+
+/*******************************************************************************
+*                               Semantic parser                               *
+*******************************************************************************/
+
+// Parses the same language as `Parser` but in a single pass: the tokens are
+// matched on the fly and the interned semantic tree is built right away (no
+// token list, no Regular AST and no prefix notation string). The parsed line
+// must outlive the parser
+struct SemanticParser {
+public:
+  using Token = Tokenizer::Token;
+
+  SemanticParser(std::string_view expressionLine, Semantic::Arena& expressionArena = Semantic::Arena::Global()) :
+    remains{expressionLine},
+    arena{expressionArena}
+  {
+    Advance();
+  }
+
+  SemanticParser& operator=(const SemanticParser&) = delete;
+  SemanticParser& operator=(SemanticParser&&) = delete;
+
+  std::shared_ptr<Semantic::Expression> ParseSemantic() {
+    Source source{*this};
+    Detail::SemanticBuilder builder{arena};
+    return ParseInfix(source, builder);
+  }
+
+  bool ParseToken(TokenType tokenType) {
+    if (current && current->first == tokenType) {
+      Advance();
+      return true;
+    }
+    return false;
+  }
+
+  std::string_view PeekToken() const {
+    if (current) {
+      return current->second;
+    } else {
+      return "";
+    }
+  }
+
+  bool IsExhausted() const {
+    return !current;
+  }
+
+private:
+  struct Source {
+    std::optional<Token> Peek() {
+      return parser.current;
+    }
+
+    void Skip() {
+      parser.Advance();
+    }
+
+    SemanticParser& parser;
+  };
+
+  // Moves `current` to the next token of the line
+  void Advance() {
+    auto pos = remains.find_first_not_of(" \t\r\f\v");
+    if (pos == std::string_view::npos) {
+      remains = {};
+      current.reset();
+      return;
+    }
+    remains.remove_prefix(pos);
+    current = Tokenizer::MatchToken(remains);
+    remains.remove_prefix(current->second.size());
+  }
+
+  std::optional<Token> current;
+  std::string_view remains;
+  Semantic::Arena& arena;
+};
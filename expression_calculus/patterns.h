@@ -0,0 +1,115 @@
+#pragma once
+
+#include "expression.h"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Compile-time patterns over semantic expressions. A pattern is a type, e.g.
+// `Impl<Any<0>, Impl<Any<1>, Any<0>>>` stands for `a -> b -> a`. `Match`
+// instantiates into a single traversal of the expression: node types are
+// checked via `GetType` (no RTTI), children are reached via `static_cast` and
+// common prefixes of the paths to the metavariables are walked only once.
+
+namespace Semantic::Patterns {
+
+// Metavariable #I: matches any expression, all the occurrences of the same
+// metavariable must match equal expressions
+template<std::size_t I>
+struct Any {};
+
+// Matches `_|_`
+struct Bot {};
+
+template<ExpressionType EXPRESSION_TYPE, typename TLeft, typename TRight>
+struct Op {};
+
+template<typename TLeft, typename TRight>
+using Impl = Op<ExpressionType::IMPLICATION, TLeft, TRight>;
+
+template<typename TLeft, typename TRight>
+using And = Op<ExpressionType::CONJUNCTION, TLeft, TRight>;
+
+template<typename TLeft, typename TRight>
+using Or = Op<ExpressionType::DISJUNCTION, TLeft, TRight>;
+
+// Expressions matched by the metavariables (indexed by the metavariable)
+constexpr std::size_t MAX_METAVARIABLES = 4;
+using Bindings = std::array<const Expression*, MAX_METAVARIABLES>;
+
+namespace Detail {
+
+// The mask of metavariables that occur in the pattern
+template<typename TPattern>
+struct Metavariables;
+
+template<std::size_t I>
+struct Metavariables<Any<I>> {
+  static_assert(I < MAX_METAVARIABLES);
+  static constexpr std::uint64_t value = std::uint64_t{1} << I;
+};
+
+template<>
+struct Metavariables<Bot> {
+  static constexpr std::uint64_t value = 0;
+};
+
+template<ExpressionType EXPRESSION_TYPE, typename TLeft, typename TRight>
+struct Metavariables<Op<EXPRESSION_TYPE, TLeft, TRight>> {
+  static constexpr std::uint64_t value = Metavariables<TLeft>::value | Metavariables<TRight>::value;
+};
+
+// `BOUND` is the mask of metavariables that are bound before the traversal
+// reaches this part of the pattern (so it's known at compile time whether an
+// occurrence binds a metavariable or is compared to the bound expression)
+template<typename TPattern, std::uint64_t BOUND>
+struct Matcher;
+
+template<std::size_t I, std::uint64_t BOUND>
+struct Matcher<Any<I>, BOUND> {
+  static bool Match(const Expression* expr, Bindings& bindings) {
+    if constexpr ((BOUND & Metavariables<Any<I>>::value) != 0) {
+      // equal expressions are interned into the same node
+      return bindings[I] == expr;
+    } else {
+      bindings[I] = expr;
+      return true;
+    }
+  }
+};
+
+template<std::uint64_t BOUND>
+struct Matcher<Bot, BOUND> {
+  static bool Match(const Expression* expr, Bindings&) {
+    return expr->GetType() == ExpressionType::BOTTOM;
+  }
+};
+
+template<ExpressionType EXPRESSION_TYPE, typename TLeft, typename TRight, std::uint64_t BOUND>
+struct Matcher<Op<EXPRESSION_TYPE, TLeft, TRight>, BOUND> {
+  static bool Match(const Expression* expr, Bindings& bindings) {
+    if (expr->GetType() != EXPRESSION_TYPE) {
+      return false;
+    }
+    auto bop = static_cast<const BinaryOperation<EXPRESSION_TYPE>*>(expr);
+    return Matcher<TLeft, BOUND>::Match(bop->left.get(), bindings)
+      && Matcher<TRight, BOUND | Metavariables<TLeft>::value>::Match(bop->right.get(), bindings);
+  }
+};
+
+}  // namespace Detail
+
+// On success `bindings[I]` holds the expression matched by `Any<I>`
+template<typename TPattern>
+bool Match(const Expression* expr, Bindings& bindings) {
+  return Detail::Matcher<TPattern, 0>::Match(expr, bindings);
+}
+
+template<typename TPattern>
+bool Match(const Expression* expr) {
+  Bindings bindings;
+  return Match<TPattern>(expr, bindings);
+}
+
+}  // namespace Semantic::Patterns
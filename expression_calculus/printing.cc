@@ -0,0 +1,150 @@
+#include "printing.h"
+
+#include <cstring>
+
+std::optional<std::string_view> RenderCache::Render(const Semantic::Expression& expr) {
+  if (auto cached = Find(expr); cached || full) {
+    return cached;
+  }
+  const std::size_t begin = text.size();
+  Append(expr);
+  if (MemoryUsage() > memoryLimit) {
+    // roll back what was rendered now, the expression will be printed directly
+    text.resize(begin);
+    text.shrink_to_fit();
+    for (auto subexpr : added) {
+      *slices->Find(*subexpr) = Slice{};
+    }
+    cachedCount -= added.size();
+    added.clear();
+    if (cachedCount == 0) {
+      slices.reset();
+    } else {
+      slices->Retain([] (const Slice& slice) {
+        return slice.end != 0;
+      });
+    }
+    full = true;
+    return std::nullopt;
+  }
+  added.clear();
+  return Find(expr);
+}
+
+std::size_t RenderCache::TextLength(const Semantic::Expression& expr) {
+  if (auto cached = Render(expr)) {
+    return cached->size();
+  }
+  struct Counter {
+    Counter& operator<<(std::string_view s) {
+      length += s.size();
+      return *this;
+    }
+
+    std::size_t length = 0;
+  } counter;
+  PrintUncached(counter, expr);
+  return counter.length;
+}
+
+void RenderCache::Append(const Semantic::Expression& expr) {
+  using namespace Semantic;
+  // an expression to append, the text between operands or the end of an
+  // operation (started at `begin`)
+  struct Item {
+    const Expression* expr;
+    std::string_view text;
+    std::size_t begin;
+  };
+  constexpr std::size_t NOT_STARTED = static_cast<std::size_t>(-1);
+  std::vector<Item> stack{{&expr, {}, NOT_STARTED}};
+  while (!stack.empty()) {
+    auto [top, itemText, begin] = stack.back();
+    stack.pop_back();
+    if (top == nullptr) {
+      Append(itemText);
+      continue;
+    }
+    if (begin != NOT_STARTED) {
+      Index(*top, begin);
+      continue;
+    }
+    if (auto cached = Find(*top)) {
+      // the source may move when `text` grows
+      const std::size_t from = cached->data() - text.data();
+      const std::size_t size = cached->size();
+      text.resize(text.size() + size);
+      std::memcpy(text.data() + text.size() - size, text.data() + from, size);
+      continue;
+    }
+    const std::size_t start = text.size();
+    switch (top->GetType()) {
+      case ExpressionType::BOTTOM:
+        Append(std::string_view{"_|_"});
+        Index(*top, start);
+        break;
+      case ExpressionType::VARIABLE:
+        Append(GetComponent<Variable>(top)->GetName());
+        Index(*top, start);
+        break;
+      case ExpressionType::CONJUNCTION:
+      case ExpressionType::DISJUNCTION:
+      case ExpressionType::IMPLICATION: {
+        auto [lhs, rhs] = Detail::Operands(*top);
+        Append(std::string_view{"("});
+        stack.push_back({top, {}, start});
+        stack.push_back({nullptr, ")", 0});
+        stack.push_back({rhs, {}, NOT_STARTED});
+        stack.push_back({nullptr, Detail::OperatorText(top->GetType()), 0});
+        stack.push_back({lhs, {}, NOT_STARTED});
+        break;
+      }
+    }
+  }
+}
+
+void RenderCache::Index(const Semantic::Expression& expr, std::size_t begin) {
+  if (!slices) {
+    slices.emplace();
+  }
+  (*slices)[expr] = Slice{begin, text.size()};
+  added.push_back(&expr);
+  cachedCount++;
+}
+
+namespace Detail {
+
+std::pair<const Semantic::Expression*, const Semantic::Expression*> Operands(const Semantic::Expression& expr) {
+  using namespace Semantic;
+  switch (expr.GetType()) {
+    case ExpressionType::CONJUNCTION: {
+      auto op = GetComponent<Conjunction>(&expr);
+      return {op->left.get(), op->right.get()};
+    }
+    case ExpressionType::DISJUNCTION: {
+      auto op = GetComponent<Disjunction>(&expr);
+      return {op->left.get(), op->right.get()};
+    }
+    case ExpressionType::IMPLICATION: {
+      auto op = GetComponent<Implication>(&expr);
+      return {op->left.get(), op->right.get()};
+    }
+    default:
+      return {nullptr, nullptr};
+  }
+}
+
+std::string_view OperatorText(ExpressionType type) {
+  switch (type) {
+    case ExpressionType::CONJUNCTION:
+      return ")&(";
+    case ExpressionType::DISJUNCTION:
+      return ")|(";
+    case ExpressionType::IMPLICATION:
+      return ")->(";
+    default:
+      return "";
+  }
+}
+
+}  // namespace Detail
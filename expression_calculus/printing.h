@@ -0,0 +1,179 @@
+#pragma once
+
+#include "expression.h"
+#include "id_map.h"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*******************************************************************************
+*                          Fully parenthesized infix                          *
+*******************************************************************************/
+
+namespace Detail {
+
+// The text between the operands of a binary operation (with the parentheses)
+std::string_view OperatorText(ExpressionType type);
+
+std::pair<const Semantic::Expression*, const Semantic::Expression*> Operands(const Semantic::Expression& expr);
+
+// Either an expression to print or a piece of text (if `expr` is null)
+struct PrintItem {
+  const Semantic::Expression* expr;
+  std::string_view text;
+};
+
+// Prints `expr` with an explicit stack (the depth of an expression is limited
+// only by the memory). `print(os, expr)` may print the whole subexpression
+// `expr` itself and return true; otherwise the operands are printed one by one.
+// With `Negations` an implication of `_|_` is printed as a negation
+template<bool Negations = false, typename TOutput, typename TPrint>
+void PrintInfix(TOutput& os, const Semantic::Expression& expr, TPrint&& print) {
+  using namespace Semantic;
+  std::vector<PrintItem> stack{{&expr, {}}};
+  while (!stack.empty()) {
+    auto [top, text] = stack.back();
+    stack.pop_back();
+    if (top == nullptr) {
+      os << text;
+    } else if (print(os, *top)) {
+      continue;
+    } else if (top->GetType() == ExpressionType::BOTTOM) {
+      os << "_|_";
+    } else if (top->GetType() == ExpressionType::VARIABLE) {
+      os << GetComponent<Variable>(top)->GetName();
+    } else if (auto impl = GetComponent<Implication>(top); Negations && impl && impl->right->GetType() == ExpressionType::BOTTOM) {
+      os << "!(";
+      stack.push_back({nullptr, ")"});
+      stack.push_back({impl->left.get(), {}});
+    } else {
+      auto [lhs, rhs] = Operands(*top);
+      os << "(";
+      stack.push_back({nullptr, ")"});
+      stack.push_back({rhs, {}});
+      stack.push_back({nullptr, OperatorText(top->GetType())});
+      stack.push_back({lhs, {}});
+    }
+  }
+}
+
+}  // namespace Detail
+
+// `TOutput` is either `std::ostream` or `OutputWriter` (anything with `<<` of
+// string views)
+template<typename TOutput>
+void PrintExpression(TOutput& os, const Semantic::Expression& expr) {
+  Detail::PrintInfix(os, expr, [] (TOutput&, const Semantic::Expression&) {
+    return false;
+  });
+}
+
+// Same as `PrintExpression` but in the syntax of the input, which has no
+// `_|_`: `a -> _|_` is printed as `!(a)` (there is no other way for `_|_` to be
+// a part of a parsed expression)
+template<typename TOutput>
+void PrintInputExpression(TOutput& os, const Semantic::Expression& expr) {
+  Detail::PrintInfix<true>(os, expr, [] (TOutput&, const Semantic::Expression&) {
+    return false;
+  });
+}
+
+/*******************************************************************************
+*                                 RenderCache                                 *
+*******************************************************************************/
+
+// Renders every distinct expression (see `PrintExpression`) at most once and
+// then copies the text. The texts are stored in a single buffer: rendering an
+// expression renders its subexpressions in place, so their texts are slices of
+// the parent's text and cost nothing but an index entry.
+//
+// The memory used by the texts and the index never exceeds `memoryLimit`: an
+// expression that doesn't fit is rendered on every print (reusing the cached
+// texts of its subexpressions). The index is a hash table of the rendered
+// expressions, so the memory depends only on what is printed, not on how many
+// expressions the arena holds. Once an expression hasn't fit, nothing more is
+// cached, so a cache serves a single proof (`b` makes one per proof of a batch
+// or of a daemon, and each of them gets the whole limit).
+class RenderCache {
+public:
+  static constexpr std::size_t DEFAULT_MEMORY_LIMIT = std::size_t{256} << 20;
+
+  explicit RenderCache(std::size_t memoryLimit = DEFAULT_MEMORY_LIMIT) : memoryLimit{memoryLimit} {}
+
+  RenderCache(const RenderCache&) = delete;
+  RenderCache& operator=(const RenderCache&) = delete;
+
+  // Same output as `PrintExpression(os, expr)`
+  template<typename TOutput>
+  void Print(TOutput& os, const Semantic::Expression& expr) {
+    if (auto text = Render(expr)) {
+      os << *text;
+    } else {
+      PrintUncached(os, expr);
+    }
+  }
+
+  // Returns the text of `expr`, rendering it if needed (`std::nullopt` if it
+  // doesn't fit). The view is valid until the next call
+  std::optional<std::string_view> Render(const Semantic::Expression& expr);
+
+  // The length of the text of `expr` (it is rendered and cached if it fits)
+  std::size_t TextLength(const Semantic::Expression& expr);
+
+  std::size_t MemoryUsage() const {
+    return text.capacity() + (slices ? slices->MemoryUsage() : 0);
+  }
+
+  // The number of expressions whose text is cached
+  std::size_t Size() const {
+    return cachedCount;
+  }
+
+private:
+  struct Slice {
+    std::size_t begin = 0;
+    std::size_t end = 0;  // 0 - not rendered (no text is empty)
+  };
+
+  std::optional<std::string_view> Find(const Semantic::Expression& expr) const {
+    const Slice* slice = slices ? slices->Find(expr) : nullptr;
+    if (slice == nullptr || slice->end == 0) {
+      return std::nullopt;
+    }
+    return std::string_view{text.data() + slice->begin, slice->end - slice->begin};
+  }
+
+  // Appends the text of `expr` to `text` and indexes every subexpression that
+  // was not there yet
+  void Append(const Semantic::Expression& expr);
+
+  // Indexes the text of `expr` that starts at `begin` and ends at the end of
+  // `text`
+  void Index(const Semantic::Expression& expr, std::size_t begin);
+
+  void Append(std::string_view s) {
+    text.insert(text.end(), s.begin(), s.end());
+  }
+
+  template<typename TOutput>
+  void PrintUncached(TOutput& os, const Semantic::Expression& expr) {
+    Detail::PrintInfix(os, expr, [this] (TOutput& out, const Semantic::Expression& subexpr) {
+      auto cached = Find(subexpr);
+      if (cached) {
+        out << *cached;
+      }
+      return cached.has_value();
+    });
+  }
+
+  std::size_t memoryLimit;
+  bool full = false;  // an expression didn't fit, so nothing is added anymore
+  std::size_t cachedCount = 0;
+  std::vector<char> text;
+  std::optional<IdMap<Slice>> slices;  // created by the first `Index`
+  std::vector<const Semantic::Expression*> added;  // indexed by the current
+                                                   // `Render`
+};
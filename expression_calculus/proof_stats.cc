@@ -0,0 +1,51 @@
+#include "proof_stats.h"
+
+#include <iomanip>
+
+namespace {
+
+double Milliseconds(const ProofStats::Phase& phase) {
+  return phase.nanoseconds.load(std::memory_order_relaxed) / 1e6;
+}
+
+}  // namespace
+
+void ProofStats::PrintJson(std::ostream& os, const std::string& parser) const {
+  const auto load = [] (const std::atomic<std::uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  };
+  double axiomMilliseconds = 0;
+  for (const auto& phase : axiomMatching) {
+    axiomMilliseconds += Milliseconds(phase);
+  }
+
+  const auto flags = os.flags();
+  os << std::fixed << std::setprecision(3);
+  os << "{\"parser\": \"" << parser << "\", \"proofs\": " << load(proofs) << ", ";
+  os << "\"phases_ms\": {"
+     << "\"reading\": " << Milliseconds(reading) << ", "
+     << "\"tokenizing\": " << Milliseconds(tokenizing) << ", "
+     << "\"parsing\": " << Milliseconds(parsing) << ", "
+     << "\"semantic_conversion\": " << Milliseconds(semanticConversion) << ", "
+     << "\"hypothesis_lookup\": " << Milliseconds(hypothesisLookup) << ", "
+     << "\"axiom_matching\": " << axiomMilliseconds << ", "
+     << "\"modus_ponens\": " << Milliseconds(modusPonens) << ", "
+     << "\"tree_building\": " << Milliseconds(treeBuilding) << ", "
+     << "\"printing\": " << Milliseconds(printing) << "}, ";
+  // by the scheme found, "0" - not an axiom
+  os << "\"axiom_matching\": {";
+  for (std::size_t scheme = 0; scheme < axiomMatching.size(); scheme++) {
+    os << (scheme == 0 ? "" : ", ") << "\"" << scheme << "\": {\"calls\": "
+       << load(axiomMatching[scheme].calls) << ", \"ms\": " << Milliseconds(axiomMatching[scheme]) << "}";
+  }
+  os << "}, ";
+  os << "\"lines\": {"
+     << "\"read\": " << load(proofLines) << ", "
+     << "\"hypotheses\": " << load(hypothesisLines) << ", "
+     << "\"axioms\": " << load(axiomLines) << ", "
+     << "\"modus_ponens\": " << load(modusPonensLines) << ", "
+     << "\"repeated\": " << load(repeatedLines) << "}, ";
+  os << "\"precalc_mp\": " << load(precalcMP) << ", \"in_need_of_lhs\": " << load(inNeedOfLhs) << ", ";
+  os << "\"output\": {\"lines\": " << load(outputLines) << ", \"bytes\": " << load(outputBytes) << "}}" << std::endl;
+  os.flags(flags);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "rules.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Wall time of the phases of the conversion and the counters of the proof
+// (see `--stats`). The phases may be timed by several threads at once (their
+// times are summed), and the stats of several proofs are summed as well
+struct ProofStats {
+  struct Phase {
+    std::atomic<std::uint64_t> nanoseconds{0};
+    std::atomic<std::uint64_t> calls{0};
+
+    void Add(std::chrono::steady_clock::duration elapsed) {
+      nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+      calls.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+
+  // With the semantic parser (the default) a line is tokenized, parsed and
+  // converted in a single pass, which is timed as `parsing`
+  Phase reading;
+  Phase tokenizing;
+  Phase parsing;
+  Phase semanticConversion;
+  Phase hypothesisLookup;
+  std::array<Phase, Rules::AXIOM_SCHEMES + 1> axiomMatching;  // by the
+                                                              // scheme found
+                                                              // (0 - none)
+  Phase modusPonens;  // `ProofChecker::AddLine` after the classification
+  Phase treeBuilding;
+  Phase printing;
+
+  std::atomic<std::uint64_t> proofs{0};
+  std::atomic<std::uint64_t> proofLines{0};  // read (without the statement)
+  std::atomic<std::uint64_t> hypothesisLines{0};
+  std::atomic<std::uint64_t> axiomLines{0};
+  std::atomic<std::uint64_t> modusPonensLines{0};
+  std::atomic<std::uint64_t> repeatedLines{0};  // skipped by `--minimize`
+  std::atomic<std::uint64_t> precalcMP{0};  // the sizes of the tables of the
+  std::atomic<std::uint64_t> inNeedOfLhs{0};  // checker at the end
+  std::atomic<std::uint64_t> outputLines{0};
+  std::atomic<std::uint64_t> outputBytes{0};
+
+  static void Add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // A single JSON object (the times are in milliseconds)
+  void PrintJson(std::ostream& os, const std::string& parser) const;
+};
+
+// Adds the time from the construction to the destruction to `phase` (nothing
+// if it is null)
+class PhaseTimer {
+public:
+  explicit PhaseTimer(ProofStats::Phase* timedPhase) : phase{timedPhase} {
+    if (phase != nullptr) {
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+  ~PhaseTimer() {
+    if (phase != nullptr) {
+      phase->Add(std::chrono::steady_clock::now() - start);
+    }
+  }
+
+private:
+  ProofStats::Phase* phase;
+  std::chrono::steady_clock::time_point start;
+};
+
+// The phase of `stats` or null if there are no stats
+inline ProofStats::Phase* PhaseOf(ProofStats* stats, ProofStats::Phase ProofStats::* phase) {
+  return stats != nullptr ? &(stats->*phase) : nullptr;
+}
@@ -1,155 +1,161 @@
 #include "rules.h"
+#include "patterns.h"
 
 namespace Rules {
+
+void NodeArena::NewBlock() {
+  blocks.push_back(std::make_unique<std::byte[]>(BLOCK_SIZE));
+  current = blocks.back().get();
+  left = BLOCK_SIZE;
+}
+
 /*******************************************************************************
 *                               Axiom matching                                *
 *******************************************************************************/
 
+namespace {
+
+using namespace Semantic::Patterns;
+
+using A = Any<0>;
+using B = Any<1>;
+using Y = Any<2>;
+
+using Ax1Pattern = Impl<A, Impl<B, A>>;  // a -> b -> a
+using Ax2Pattern = Impl<Impl<A, B>, Impl<Impl<A, Impl<B, Y>>, Impl<A, Y>>>;  // (a -> b) -> (a -> b -> y) -> (a -> y)
+using Ax3Pattern = Impl<A, Impl<B, And<A, B>>>;  // a -> b -> a & b
+using Ax4Pattern = Impl<And<A, B>, A>;  // a & b -> a
+using Ax5Pattern = Impl<And<A, B>, B>;  // a & b -> b
+using Ax6Pattern = Impl<A, Or<A, B>>;  // a -> a | b
+using Ax7Pattern = Impl<B, Or<A, B>>;  // b -> a | b
+using Ax8Pattern = Impl<Impl<A, Y>, Impl<Impl<B, Y>, Impl<Or<A, B>, Y>>>;  // (a -> y) -> (b -> y) -> (a | b -> y)
+using Ax9Pattern = Impl<Impl<A, B>, Impl<Impl<A, Impl<B, Bot>>, Impl<A, Bot>>>;  // (a -> b) -> (a -> b -> _|_) -> (a -> _|_)
+using Ax10Pattern = Impl<A, Impl<Impl<A, Bot>, B>>;  // a -> (a -> _|_) -> b
+
+}  // namespace
+
 bool MatchAx1(const Semantic::Expression* expr) {
-  // a1 -> b -> a2
-  using namespace Semantic;
-  auto a1 = GetComponent<Expression>(expr, &Implication::left);
-  auto a2 = GetComponent<Expression>(expr, &Implication::right, &Implication::right);
-  return a1 && a2 && *a1 == *a2;
+  return Match<Ax1Pattern>(expr);
 }
 
 bool MatchAx2(const Semantic::Expression* expr) {
-  // (a1 -> b1) -> (a2 -> b2 -> y1) -> (a3 -> y2)
-  using namespace Semantic;
-  constexpr auto l = &Implication::left;
-  constexpr auto r = &Implication::right;
-  auto a1 = GetComponent<Expression>(expr, l, l);
-  auto b1 = GetComponent<Expression>(expr, l, r);
-
-  auto a2 = GetComponent<Expression>(expr, r, l, l);
-  auto b2 = GetComponent<Expression>(expr, r, l, r, l);
-  auto y1 = GetComponent<Expression>(expr, r, l, r, r);
-
-  auto a3 = GetComponent<Expression>(expr, r, r, l);
-  auto y2 = GetComponent<Expression>(expr, r, r, r);
-  return a1 && a2 && a3 && b1 && b2 && y1 && y2
-    && *a1 == *a2 && *a2 == *a3
-    && *b1 == *b2
-    && *y1 == *y2;
+  return Match<Ax2Pattern>(expr);
 }
 
 bool MatchAx3(const Semantic::Expression* expr) {
-  // a1 -> b1 -> a2 & b2
-  using namespace Semantic;
-  auto a1 = GetComponent<Expression>(expr, &Implication::left);
-  auto b1 = GetComponent<Expression>(expr, &Implication::right, &Implication::left);
-
-  auto a2 = GetComponent<Expression>(expr, &Implication::right, &Implication::right, &Conjunction::left);
-  auto b2 = GetComponent<Expression>(expr, &Implication::right, &Implication::right, &Conjunction::right);
-  return a1 && a2 && b1 && b2
-    && *a1 == *a2
-    && *b1 == *b2;
+  return Match<Ax3Pattern>(expr);
 }
 
 bool MatchAx4(const Semantic::Expression* expr) {
-  // a1 && b -> a2
-  using namespace Semantic;
-  auto a1 = GetComponent<Expression>(expr, &Implication::left, &Conjunction::left);
-  auto a2 = GetComponent<Expression>(expr, &Implication::right);
-  return a1 && a2 && *a1 == *a2;
+  return Match<Ax4Pattern>(expr);
 }
 
 bool MatchAx5(const Semantic::Expression* expr) {
-  // a && b1 -> b2
-  using namespace Semantic;
-  auto b1 = GetComponent<Expression>(expr, &Implication::left, &Conjunction::right);
-  auto b2 = GetComponent<Expression>(expr, &Implication::right);
-  return b1 && b2 && *b1 == *b2;
+  return Match<Ax5Pattern>(expr);
 }
 
 bool MatchAx6(const Semantic::Expression* expr) {
-  // a1 -> a2 | b
-  using namespace Semantic;
-  auto a1 = GetComponent<Expression>(expr, &Implication::left);
-  auto a2 = GetComponent<Expression>(expr, &Implication::right, &Disjunction::left);
-  return a1 && a2 && *a1 == *a2;
+  return Match<Ax6Pattern>(expr);
 }
 
 bool MatchAx7(const Semantic::Expression* expr) {
-  // b1 -> a | b2
-  using namespace Semantic;
-  auto b1 = GetComponent<Expression>(expr, &Implication::left);
-  auto b2 = GetComponent<Expression>(expr, &Implication::right, &Disjunction::right);
-  return b1 && b2 && *b1 == *b2;
+  return Match<Ax7Pattern>(expr);
 }
 
 bool MatchAx8(const Semantic::Expression* expr) {
-  // (a1 -> y1) -> (b1 -> y2) -> (a2 | b2 -> y3)
-  using namespace Semantic;
-  constexpr auto il = &Implication::left;
-  constexpr auto ir = &Implication::right;
-  constexpr auto dl = &Disjunction::left;
-  constexpr auto dr = &Disjunction::right;
-  auto a1 = GetComponent<Expression>(expr, il, il);
-  auto y1 = GetComponent<Expression>(expr, il, ir);
-
-  auto b1 = GetComponent<Expression>(expr, ir, il, il);
-  auto y2 = GetComponent<Expression>(expr, ir, il, ir);
-
-  auto a2 = GetComponent<Expression>(expr, ir, ir, il, dl);
-  auto b2 = GetComponent<Expression>(expr, ir, ir, il, dr);
-  auto y3 = GetComponent<Expression>(expr, ir, ir, ir);
-
-  return a1 && a2 && b1 && b2 && y1 && y2 && y3
-    && *a1 == *a2
-    && *b1 == *b2
-    && *y1 == *y2 && *y2 == *y3;
+  return Match<Ax8Pattern>(expr);
 }
 
 bool MatchAx9(const Semantic::Expression* expr) {
-  // (a1 -> b1) -> (a2 -> b2 -> _|_1) -> (a3 -> _|_2)
-  using namespace Semantic;
-  constexpr auto l = &Implication::left;
-  constexpr auto r = &Implication::right;
-  auto a1 = GetComponent<Expression>(expr, l, l);
-  auto b1 = GetComponent<Expression>(expr, l, r);
-
-  auto a2 = GetComponent<Expression>(expr, r, l, l);
-  auto b2 = GetComponent<Expression>(expr, r, l, r, l);
-  auto bot1 = GetComponent<Bottom>(expr, r, l, r, r);
-
-  auto a3 = GetComponent<Expression>(expr, r, r, l);
-  auto bot2 = GetComponent<Bottom>(expr, r, r, r);
-
-  return a1 && a2 && a3 && b1 && b2 && bot1 && bot2
-    && *a1 == *a2 && *a2 == *a3
-    && *b1 == *b2
-    && *bot1 == *bot2;
+  return Match<Ax9Pattern>(expr);
 }
 
 bool MatchAx10(const Semantic::Expression* expr) {
-  // a1 -> (a2 -> bot) -> b
-  using namespace Semantic;
-
-  auto a1 = Semantic::GetComponent<Expression>(expr, &Implication::left);
-  auto a2 = Semantic::GetComponent<Expression>(expr, &Implication::right, &Implication::left, &Implication::left);
-  auto bot = Semantic::GetComponent<Bottom>(expr, &Implication::right, &Implication::left, &Implication::right);
+  return Match<Ax10Pattern>(expr);
+}
 
-  return a1 && a2 && bot && *a1 == *a2;
+std::size_t ClassifyAxiom(const Semantic::Expression* expr) {
+  using namespace Semantic;
+  constexpr auto bit = [] (std::size_t scheme) -> std::uint32_t {
+    return std::uint32_t{1} << scheme;
+  };
+  constexpr auto typeOf = [] (const std::shared_ptr<Expression>& e) {
+    return e->GetType();
+  };
+
+  auto impl = GetComponent<Implication>(expr);
+  if (impl == nullptr) {
+    return NOT_AN_AXIOM;
+  }
+
+  // Candidates are filtered by the node types of the first levels (every
+  // scheme is an implication)
+  std::uint32_t candidates = 0;
+  const auto lhsType = typeOf(impl->left);
+  if (lhsType == ExpressionType::CONJUNCTION) {
+    candidates |= bit(4) | bit(5);
+  }
+  if (auto rhs = GetComponent<Implication>(impl->right.get())) {
+    // a -> (... -> ...)
+    candidates |= bit(1);
+    const auto rlType = typeOf(rhs->left);
+    const auto rrType = typeOf(rhs->right);
+    if (rrType == ExpressionType::CONJUNCTION) {
+      candidates |= bit(3);
+    }
+    if (rlType == ExpressionType::IMPLICATION) {
+      auto rl = static_cast<const Implication*>(rhs->left.get());
+      if (typeOf(rl->right) == ExpressionType::BOTTOM) {
+        candidates |= bit(10);
+      }
+      if (lhsType == ExpressionType::IMPLICATION && rrType == ExpressionType::IMPLICATION) {
+        // (... -> ...) -> (... -> ...) -> (... -> ...)
+        auto rr = static_cast<const Implication*>(rhs->right.get());
+        candidates |= bit(2);
+        if (typeOf(rr->left) == ExpressionType::DISJUNCTION) {
+          candidates |= bit(8);
+        }
+        if (typeOf(rr->right) == ExpressionType::BOTTOM) {
+          candidates |= bit(9);
+        }
+      }
+    }
+  } else if (typeOf(impl->right) == ExpressionType::DISJUNCTION) {
+    candidates |= bit(6) | bit(7);
+  }
+
+  // Only the equalities of metavariable occurrences are left to check
+  using TMatcher = bool(*)(const Expression*);
+  static constexpr TMatcher matchers[AXIOM_SCHEMES + 1] = {
+    nullptr,
+    Match<Ax1Pattern>, Match<Ax2Pattern>, Match<Ax3Pattern>, Match<Ax4Pattern>, Match<Ax5Pattern>,
+    Match<Ax6Pattern>, Match<Ax7Pattern>, Match<Ax8Pattern>, Match<Ax9Pattern>, Match<Ax10Pattern>,
+  };
+  for (std::size_t scheme = 1; scheme <= AXIOM_SCHEMES; scheme++) {
+    if ((candidates & bit(scheme)) != 0 && matchers[scheme](expr)) {
+      return scheme;
+    }
+  }
+  return NOT_AN_AXIOM;
 }
 
 /*******************************************************************************
 *                             Axiom tree building                             *
 *******************************************************************************/
 
-std::shared_ptr<NaturalNode> MakeAx1(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx1(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a -> b -> a`
   using namespace Semantic;
   auto a = GetComponent<Implication>(phi.get())->left;
   auto bArrowA = GetComponent<Implication>(phi.get())->right;
   auto b = GetComponent<Implication>(phi.get(), &Implication::right)->left;
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-      std::make_shared<IImpl>(a, bArrowA,
-        std::make_shared<Ax>(b, a)));
+    nodes.Make<IImpl>(TPtr{}, phi,
+      nodes.Make<IImpl>(a, bArrowA,
+        nodes.Make<Ax>(b, a)));
 }
 
-std::shared_ptr<NaturalNode> MakeAx2(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx2(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `(a -> b) -> (a -> b -> y) -> (a -> y)`
   using namespace Semantic;
   auto ab = GetComponent<Implication>(phi.get())->left;
@@ -161,19 +167,19 @@ std::shared_ptr<NaturalNode> MakeAx2(std::shared_ptr<Semantic::Expression> phi)
   auto y = GetComponent<Implication>(ay.get())->right;
   auto by = GetComponent<Implication>(aby.get())->right;
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IImpl>(ab, abyAy,
-          std::make_shared<IImpl>(aby, ay,
-            std::make_shared<EImpl>(a, y,
-              std::make_shared<EImpl>(TPtr{}, by,
-                std::make_shared<Ax>(TPtr{}, aby),
-                std::make_shared<Ax>(TPtr{}, a)),
-              std::make_shared<EImpl>(TPtr{}, b,
-                std::make_shared<Ax>(TPtr{}, ab),
-                std::make_shared<Ax>(TPtr{}, a))))));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IImpl>(ab, abyAy,
+          nodes.Make<IImpl>(aby, ay,
+            nodes.Make<EImpl>(a, y,
+              nodes.Make<EImpl>(TPtr{}, by,
+                nodes.Make<Ax>(TPtr{}, aby),
+                nodes.Make<Ax>(TPtr{}, a)),
+              nodes.Make<EImpl>(TPtr{}, b,
+                nodes.Make<Ax>(TPtr{}, ab),
+                nodes.Make<Ax>(TPtr{}, a))))));
 }
 
-std::shared_ptr<NaturalNode> MakeAx3(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx3(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a -> b -> a & b`
   using namespace Semantic;
   auto bArrowAAndB = GetComponent<Implication>(phi.get())->right;  // b -> a & b
@@ -181,62 +187,62 @@ std::shared_ptr<NaturalNode> MakeAx3(std::shared_ptr<Semantic::Expression> phi)
   auto a = GetComponent<Conjunction>(aAndB.get())->left;  // a
   auto b = GetComponent<Conjunction>(aAndB.get())->right;  // b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IImpl>(a, bArrowAAndB,
-          std::make_shared<ICon>(b, aAndB,
-            std::make_shared<Ax>(TPtr{}, a),
-            std::make_shared<Ax>(TPtr{}, b))));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IImpl>(a, bArrowAAndB,
+          nodes.Make<ICon>(b, aAndB,
+            nodes.Make<Ax>(TPtr{}, a),
+            nodes.Make<Ax>(TPtr{}, b))));
 }
 
-std::shared_ptr<NaturalNode> MakeAx4(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx4(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a & b -> a`
   using namespace Semantic;
   auto aAndB = GetComponent<Implication>(phi.get())->left;  // a & b
   auto a = GetComponent<Conjunction>(aAndB.get())->left;  // a
   auto b = GetComponent<Conjunction>(aAndB.get())->right;  // b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<ElCon>(aAndB, a,
-          std::make_shared<Ax>(TPtr{}, aAndB)));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<ElCon>(aAndB, a,
+          nodes.Make<Ax>(TPtr{}, aAndB)));
 }
 
-std::shared_ptr<NaturalNode> MakeAx5(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx5(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a & b -> b`
   using namespace Semantic;
   auto aAndB = GetComponent<Implication>(phi.get())->left;  // a & b
   auto a = GetComponent<Conjunction>(aAndB.get())->left;  // a
   auto b = GetComponent<Conjunction>(aAndB.get())->right;  // b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<ErCon>(aAndB, b,
-          std::make_shared<Ax>(TPtr{}, aAndB)));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<ErCon>(aAndB, b,
+          nodes.Make<Ax>(TPtr{}, aAndB)));
 }
 
-std::shared_ptr<NaturalNode> MakeAx6(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx6(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a -> a | b`
   using namespace Semantic;
   auto aOrB = GetComponent<Implication>(phi.get())->right;  // a | b
   auto a = GetComponent<Disjunction>(aOrB.get())->left;  // a
   auto b = GetComponent<Disjunction>(aOrB.get())->right;  // b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IlDis>(a, aOrB,
-          std::make_shared<Ax>(TPtr{}, a)));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IlDis>(a, aOrB,
+          nodes.Make<Ax>(TPtr{}, a)));
 }
 
-std::shared_ptr<NaturalNode> MakeAx7(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx7(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `b -> a | b`
   using namespace Semantic;
   auto aOrB = GetComponent<Implication>(phi.get())->right;  // a | b
   auto a = GetComponent<Disjunction>(aOrB.get())->left;  // a
   auto b = GetComponent<Disjunction>(aOrB.get())->right;  // b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IrDis>(b, aOrB,
-          std::make_shared<Ax>(TPtr{}, b)));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IrDis>(b, aOrB,
+          nodes.Make<Ax>(TPtr{}, b)));
 }
 
-std::shared_ptr<NaturalNode> MakeAx8(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx8(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `(a -> y) -> (b -> y) -> (a | b -> y)`
   using namespace Semantic;
   auto ay = GetComponent<Implication>(phi.get())->left;  // a -> b
@@ -248,20 +254,20 @@ std::shared_ptr<NaturalNode> MakeAx8(std::shared_ptr<Semantic::Expression> phi)
   auto b = GetComponent<Disjunction>(ab.get())->right;  // b
   auto y = GetComponent<Implication>(aby.get())->right;  // y
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IImpl>(ay, byaby,
-          std::make_shared<IImpl>(by, aby,
-            std::make_shared<EDis>(ab, y,
-              std::make_shared<EImpl>(a, y,
-                std::make_shared<Ax>(TPtr{}, ay),
-                std::make_shared<Ax>(TPtr{}, a)),
-              std::make_shared<EImpl>(b, y,
-                std::make_shared<Ax>(TPtr{}, by),
-                std::make_shared<Ax>(TPtr{}, b)),
-              std::make_shared<Ax>(TPtr{}, ab)))));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IImpl>(ay, byaby,
+          nodes.Make<IImpl>(by, aby,
+            nodes.Make<EDis>(ab, y,
+              nodes.Make<EImpl>(a, y,
+                nodes.Make<Ax>(TPtr{}, ay),
+                nodes.Make<Ax>(TPtr{}, a)),
+              nodes.Make<EImpl>(b, y,
+                nodes.Make<Ax>(TPtr{}, by),
+                nodes.Make<Ax>(TPtr{}, b)),
+              nodes.Make<Ax>(TPtr{}, ab)))));
 }
 
-std::shared_ptr<NaturalNode> MakeAx9(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx9(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `(a -> b) -> (a -> b -> _|_) -> (a -> _|_)`
   using namespace Semantic;
   auto ab = GetComponent<Implication>(phi.get())->left;  // a -> b
@@ -273,19 +279,19 @@ std::shared_ptr<NaturalNode> MakeAx9(std::shared_ptr<Semantic::Expression> phi)
   auto b = GetComponent<Implication>(ab.get())->right;  // b
   auto bot = GetComponent<Implication>(a_.get())->right;  // _|_
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IImpl>(ab, ab_a_,
-          std::make_shared<IImpl>(ab_, a_,
-            std::make_shared<EImpl>(a, bot,
-              std::make_shared<EImpl>(TPtr{}, b_,
-                std::make_shared<Ax>(TPtr{}, ab_),
-                std::make_shared<Ax>(TPtr{}, a)),
-              std::make_shared<EImpl>(TPtr{}, b,
-                std::make_shared<Ax>(TPtr{}, ab),
-                std::make_shared<Ax>(TPtr{}, a))))));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IImpl>(ab, ab_a_,
+          nodes.Make<IImpl>(ab_, a_,
+            nodes.Make<EImpl>(a, bot,
+              nodes.Make<EImpl>(TPtr{}, b_,
+                nodes.Make<Ax>(TPtr{}, ab_),
+                nodes.Make<Ax>(TPtr{}, a)),
+              nodes.Make<EImpl>(TPtr{}, b,
+                nodes.Make<Ax>(TPtr{}, ab),
+                nodes.Make<Ax>(TPtr{}, a))))));
 }
 
-std::shared_ptr<NaturalNode> MakeAx10(std::shared_ptr<Semantic::Expression> phi) {
+const NaturalNode* MakeAx10(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi) {
   // Precondition: phi has a structure like `a -> (a -> _|_) -> b`
   using namespace Semantic;
   auto a_b = GetComponent<Implication>(phi.get())->right;  // (a -> _|_) -> b
@@ -293,23 +299,28 @@ std::shared_ptr<NaturalNode> MakeAx10(std::shared_ptr<Semantic::Expression> phi)
   auto b = GetComponent<Implication>(a_b.get())->right;  // b
   auto a_ = GetComponent<Implication>(a_b.get())->left;  // a -> _|_
   auto bot = GetComponent<Implication>(a_.get())->right;  // _|_
-  auto _b = std::make_shared<Implication>(std::string_view{}, bot, b); // _|_ -> b
-  //        v---------------------------------------^
-  // this stuff is super sketchy!!! We violate the invariant but it's reasonable
-  // because we won't calculate hash and compare expressions inside NaturalNode
-  // (this AST serves only as an intermediate representation)
+  auto _b = Arena::Global().MakeBinary(ExpressionType::IMPLICATION, bot, b); // _|_ -> b
   return
-    std::make_shared<IImpl>(TPtr{}, phi,
-        std::make_shared<IImpl>(a, a_b,
-          std::make_shared<EImpl>(a_, b,
-            std::make_shared<IImpl>(TPtr{}, _b,
-              std::make_shared<EBot>(bot, b,
-                std::make_shared<Ax>(TPtr{}, bot))),
-            std::make_shared<EImpl>(TPtr{}, bot,
-              std::make_shared<Ax>(TPtr{}, a_),
-              std::make_shared<Ax>(TPtr{}, a)))));
+    nodes.Make<IImpl>(TPtr{}, phi,
+        nodes.Make<IImpl>(a, a_b,
+          nodes.Make<EImpl>(a_, b,
+            nodes.Make<IImpl>(TPtr{}, _b,
+              nodes.Make<EBot>(bot, b,
+                nodes.Make<Ax>(TPtr{}, bot))),
+            nodes.Make<EImpl>(TPtr{}, bot,
+              nodes.Make<Ax>(TPtr{}, a_),
+              nodes.Make<Ax>(TPtr{}, a)))));
 }
 
+const NaturalNode* MakeAx(NodeArena& nodes, std::size_t scheme, const std::shared_ptr<Semantic::Expression>& phi) {
+  using TMaker = const NaturalNode*(*)(NodeArena&, const std::shared_ptr<Semantic::Expression>&);
+  static constexpr TMaker makers[AXIOM_SCHEMES + 1] = {
+    nullptr,
+    MakeAx1, MakeAx2, MakeAx3, MakeAx4, MakeAx5, MakeAx6, MakeAx7, MakeAx8, MakeAx9, MakeAx10,
+  };
+  assert(1 <= scheme && scheme <= AXIOM_SCHEMES);
+  return makers[scheme](nodes, phi);
+}
 
 }  // namespace Rules
 
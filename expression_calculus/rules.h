@@ -2,42 +2,99 @@
 
 #include "expression.h"
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
 
 namespace Rules {
 
 using TPtr = std::shared_ptr<Semantic::Expression>;
 
+// The nodes are allocated from a `NodeArena` and never freed one by one, so
+// they don't own each other and are trivially destructible: the children and
+// the expressions (which are owned by `Semantic::Arena`) are plain pointers
 struct NaturalNode {
-  NaturalNode(TPtr additionalHypothesis, TPtr expression) :
-    addHyp{additionalHypothesis},
-    expr{expression}
+  NaturalNode(const TPtr& additionalHypothesis, const TPtr& expression) :
+    addHyp{additionalHypothesis.get()},
+    expr{expression.get()}
   {}
 
-  TPtr addHyp;  // = nullptr if the context is the same as parents'. Else - this
-                // expression should be added to the context of the parent
-  TPtr expr;
+  const Semantic::Expression* addHyp;  // = nullptr if the context is the same
+                                       // as parents'. Else - this expression
+                                       // should be added to the context of the
+                                       // parent
+  const Semantic::Expression* expr;
 
   virtual std::string_view GetAnnotation() const = 0;
-  virtual std::vector<std::shared_ptr<NaturalNode>> GetChildren() const = 0;
-
-  virtual ~NaturalNode() = default;
+  virtual std::size_t ChildrenCount() const = 0;
+  virtual const NaturalNode* GetChild(std::size_t i) const = 0;
 };
 
 template<std::size_t Children, const char* Annotation>
 struct GenericNode : NaturalNode {
   template<typename... TChildren, typename = std::enable_if_t<Children == sizeof...(TChildren)>>
-  GenericNode(TPtr hyp, TPtr psi, TChildren&&... c) : NaturalNode{hyp, psi}, children{std::forward<TChildren>(c)...} {}
+  GenericNode(const TPtr& hyp, const TPtr& psi, TChildren... c) : NaturalNode{hyp, psi}, children{c...} {}
 
   virtual std::string_view GetAnnotation() const final {
     return Annotation;
   }
 
-  virtual std::vector<std::shared_ptr<NaturalNode>> GetChildren() const final {
-    return std::vector<std::shared_ptr<NaturalNode>>(children.begin(), children.end());
+  virtual std::size_t ChildrenCount() const final {
+    return Children;
+  }
+
+  virtual const NaturalNode* GetChild(std::size_t i) const final {
+    return children[i];
   }
 
-  std::array<std::shared_ptr<NaturalNode>, Children> children;
+  std::array<const NaturalNode*, Children> children;
+};
+
+// Bump allocator of the nodes of a proof: a node is placed right after the
+// previous one in a large block and all the blocks are released at once with
+// the arena (no destructors are run, see `NaturalNode`)
+class NodeArena {
+public:
+  NodeArena() = default;
+
+  NodeArena(const NodeArena&) = delete;
+  NodeArena& operator=(const NodeArena&) = delete;
+
+  template<typename TNode, typename... TArgs>
+  const TNode* Make(TArgs&&... args) {
+    static_assert(std::is_trivially_destructible_v<TNode>);
+    return new (Allocate(sizeof(TNode), alignof(TNode))) TNode(std::forward<TArgs>(args)...);
+  }
+
+  // The memory taken by the blocks
+  std::size_t MemoryUsage() const {
+    return blocks.size() * BLOCK_SIZE;
+  }
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = std::size_t{64} << 10;
+
+  void* Allocate(std::size_t size, std::size_t alignment) {
+    std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current) % alignment) % alignment;
+    if (current == nullptr || padding + size > left) {
+      NewBlock();
+      padding = 0;
+    }
+    void* result = current + padding;
+    current += padding + size;
+    left -= padding + size;
+    return result;
+  }
+
+  void NewBlock();
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks;
+  std::byte* current = nullptr;
+  std::size_t left = 0;
 };
 
 namespace Detail {
@@ -88,28 +145,40 @@ bool MatchAx9(const Semantic::Expression* expr);
 
 bool MatchAx10(const Semantic::Expression* expr);
 
+constexpr std::size_t NOT_AN_AXIOM = 0;
+constexpr std::size_t AXIOM_SCHEMES = 10;
+
+// Returns the number (1..10) of the first axiom scheme `expr` is an instance
+// of (i.e. the same scheme as the chain of MatchAx1..MatchAx10 would find) or
+// NOT_AN_AXIOM. The shape of the top levels of `expr` is inspected only once;
+// the rest of the checks are made only for the schemes of the matching shape
+std::size_t ClassifyAxiom(const Semantic::Expression* expr);
+
 /*******************************************************************************
 *                             Axiom tree building                             *
 *******************************************************************************/
 
-std::shared_ptr<NaturalNode> MakeAx1(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx1(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
+
+const NaturalNode* MakeAx2(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx2(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx3(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx3(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx4(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx4(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx5(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx5(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx6(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx6(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx7(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx7(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx8(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx8(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx9(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx9(std::shared_ptr<Semantic::Expression> phi);
+const NaturalNode* MakeAx10(NodeArena& nodes, const std::shared_ptr<Semantic::Expression>& phi);
 
-std::shared_ptr<NaturalNode> MakeAx10(std::shared_ptr<Semantic::Expression> phi);
+// Precondition: `phi` is an instance of the axiom scheme number `scheme`
+const NaturalNode* MakeAx(NodeArena& nodes, std::size_t scheme, const std::shared_ptr<Semantic::Expression>& phi);
 
 }  // namespace Rules
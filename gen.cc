@@ -0,0 +1,315 @@
+// Generates task B proofs for the scaling and the worst-case tests of `b`:
+//   ./gen [options] >proof
+//
+// A random proof (the default) is built from hypotheses, instances of the
+// axiom schemes and modus ponens. Its knobs:
+//   --lines N            the number of the lines of the proof (1000)
+//   --hypotheses N       the number of the hypotheses of the statement (2)
+//   --variables N        the number of the distinct variables (8)
+//   --formula-size N     the number of the variables in a random formula (4)
+//   --depth N            the nesting depth of a random formula at most (8)
+//   --axiom-share P      the share of the lines which are axioms, at least (0.4)
+//   --fan-in N           how many modus ponens use the same premise (1)
+//   --reuse P            the chance that a premise is picked among all the
+//                        proven formulas instead of the latest one (0.5)
+//   --error-at N         the number of the proof line (from 1) which is
+//                        replaced by a formula that can't be proven
+//   --wrong-conclusion   the statement claims another formula
+//   --seed N             the seed of the random generator (1)
+//
+// `--adversarial KIND` generates a proof of `--lines` lines that is slow to
+// convert instead:
+//   right-nested   axioms with right-nested implications of `--depth` levels
+//                  (deep formulas for the hashing and the printing)
+//   deep-chain     a chain of modus ponens whose tree is as deep as the proof
+//                  is long
+//   growing-chain  every modus ponens proves a formula one implication longer
+//                  than the previous one (the sizes of the proof and of the
+//                  output are quadratic)
+
+#include "utils/output.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+  std::size_t lines = 1000;
+  std::size_t hypotheses = 2;
+  std::size_t variables = 8;
+  std::size_t formulaSize = 4;
+  std::size_t depth = 8;
+  double axiomShare = 0.4;
+  std::size_t fanIn = 1;
+  double reuse = 0.5;
+  std::optional<std::size_t> errorAt;
+  bool wrongConclusion = false;
+  std::optional<std::string> adversarial;
+  unsigned long seed = 1;
+};
+
+struct Proof {
+  std::vector<std::string> hypotheses;
+  std::vector<std::string> lines;
+};
+
+// A formula that no proof of the generator proves (none of the generated
+// formulas has this variable)
+constexpr std::string_view UNPROVABLE = "ERR";
+
+// The generated formulas are fully parenthesized, so any formula may be put in
+// place of a metavariable
+std::string Parens(const std::string& formula) {
+  return "(" + formula + ")";
+}
+
+std::string Implies(const std::string& lhs, const std::string& rhs) {
+  return Parens(lhs) + "->" + Parens(rhs);
+}
+
+class RandomProof {
+public:
+  RandomProof(const Options& proofOptions) : options{proofOptions}, random{proofOptions.seed} {}
+
+  Proof Generate() {
+    Proof proof;
+    for (std::size_t i = 0; i < options.hypotheses; i++) {
+      proof.hypotheses.push_back(Formula());
+    }
+
+    std::vector<std::string> pending;  // proven by a modus ponens, not emitted
+    std::optional<std::string> premise;
+    std::size_t premiseUses = 0;
+    for (std::size_t i = 0; i < options.lines; i++) {
+      if (!pending.empty() && !Chance(options.axiomShare)) {
+        // the conclusions are emitted in a random order, so the implications
+        // wait for their premises for a while
+        std::swap(pending[Uniform(pending.size())], pending.back());
+        Prove(proof, pending.back());
+        pending.pop_back();
+      } else if (!proof.hypotheses.empty() && Chance(HYPOTHESIS_SHARE)) {
+        Prove(proof, proof.hypotheses[Uniform(proof.hypotheses.size())]);
+      } else if (!proven.empty() && Chance(0.5)) {
+        // p->(x->p) (the first axiom scheme), whose modus ponens with p proves
+        // x->p
+        if (premiseUses == 0) {
+          premise = Chance(options.reuse) ? proven[Uniform(proven.size())] : proven.back();
+          premiseUses = options.fanIn;
+        }
+        premiseUses--;
+        const std::string x = Formula();
+        Prove(proof, Implies(*premise, Implies(x, *premise)));
+        pending.push_back(Implies(x, *premise));
+      } else {
+        Prove(proof, Axiom());
+      }
+    }
+    return proof;
+  }
+
+private:
+  static constexpr double HYPOTHESIS_SHARE = 0.05;
+
+  bool Chance(double p) {
+    return std::uniform_real_distribution<double>{0, 1}(random) < p;
+  }
+
+  std::size_t Uniform(std::size_t n) {
+    return std::uniform_int_distribution<std::size_t>{0, n - 1}(random);
+  }
+
+  void Prove(Proof& proof, const std::string& formula) {
+    proof.lines.push_back(formula);
+    // the longer premises are not reused, so that the formulas don't grow
+    // with the length of the proof
+    if (formula.size() <= 32 * (options.formulaSize + 1)) {
+      proven.push_back(formula);
+    }
+  }
+
+  std::string Variable() {
+    return "P" + std::to_string(Uniform(std::max<std::size_t>(options.variables, 1)));
+  }
+
+  // A random formula of `size` variables at most `depth` levels deep
+  std::string Formula(std::size_t size, std::size_t depth) {
+    if (size <= 1 || depth == 0) {
+      return Chance(0.2) ? "!" + Variable() : Variable();
+    }
+    static const char* operators[] = {"&", "|", "->"};
+    const std::size_t lhsSize = 1 + Uniform(size - 1);
+    return Parens(Formula(lhsSize, depth - 1)) + operators[Uniform(3)] + Parens(Formula(size - lhsSize, depth - 1));
+  }
+
+  std::string Formula() {
+    return Formula(options.formulaSize, options.depth);
+  }
+
+  // An instance of a random axiom scheme
+  std::string Axiom() {
+    const std::string a = Formula();
+    const std::string b = Formula();
+    const std::string c = Formula();
+    const std::string pa = Parens(a);
+    const std::string pb = Parens(b);
+    switch (1 + Uniform(10)) {
+      case 1:
+        return Implies(a, Implies(b, a));
+      case 2:
+        return Implies(Implies(a, b), Implies(Implies(a, Implies(b, c)), Implies(a, c)));
+      case 3:
+        return Implies(a, Implies(b, pa + "&" + pb));
+      case 4:
+        return Implies(pa + "&" + pb, a);
+      case 5:
+        return Implies(pa + "&" + pb, b);
+      case 6:
+        return Implies(a, pa + "|" + pb);
+      case 7:
+        return Implies(b, pa + "|" + pb);
+      case 8:
+        return Implies(Implies(a, c), Implies(Implies(b, c), Implies(pa + "|" + pb, c)));
+      case 9:
+        return Implies(Implies(a, b), Implies(Implies(a, "!" + pb), "!" + pa));
+      default:
+        return Implies(a, Implies("!" + pa, b));
+    }
+  }
+
+  const Options& options;
+  std::mt19937_64 random;
+  std::vector<std::string> proven;  // the premises to choose from
+};
+
+// `A->(A->(...->(A)...))` with `depth` implications
+std::string RightNested(std::size_t depth, std::string_view variable) {
+  std::string formula;
+  for (std::size_t i = 0; i < depth; i++) {
+    formula.append(variable).append("->(");
+  }
+  formula.append(variable);
+  formula.append(depth, ')');
+  return formula;
+}
+
+std::optional<Proof> AdversarialProof(const Options& options) {
+  Proof proof;
+  const std::string_view kind = *options.adversarial;
+  if (kind == "right-nested") {
+    for (std::size_t i = 0; i < options.lines; i++) {
+      const std::string variable = "P" + std::to_string(i % std::max<std::size_t>(options.variables, 1));
+      proof.lines.push_back(Implies(RightNested(options.depth, variable), Implies("Q", RightNested(options.depth, variable))));
+    }
+  } else if (kind == "deep-chain") {
+    proof.hypotheses = {"A", "A->A"};
+    proof.lines.push_back("A");
+    while (proof.lines.size() + 2 <= options.lines) {
+      proof.lines.push_back("A->A");
+      proof.lines.push_back("A");
+    }
+  } else if (kind == "growing-chain") {
+    // p, p->(Q->p), Q->p, (Q->p)->(Q->(Q->p)), ...
+    proof.hypotheses = {"A"};
+    std::string formula = "A";
+    proof.lines.push_back(formula);
+    while (proof.lines.size() + 2 <= options.lines) {
+      const std::string next = Implies("Q", formula);
+      proof.lines.push_back(Implies(formula, next));
+      proof.lines.push_back(next);
+      formula = next;
+    }
+  } else {
+    return std::nullopt;
+  }
+  return proof;
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--lines" && hasValue) {
+      options.lines = std::stoull(argv[++i]);
+    } else if (arg == "--hypotheses" && hasValue) {
+      options.hypotheses = std::stoull(argv[++i]);
+    } else if (arg == "--variables" && hasValue) {
+      options.variables = std::stoull(argv[++i]);
+    } else if (arg == "--formula-size" && hasValue) {
+      options.formulaSize = std::stoull(argv[++i]);
+    } else if (arg == "--depth" && hasValue) {
+      options.depth = std::stoull(argv[++i]);
+    } else if (arg == "--axiom-share" && hasValue) {
+      options.axiomShare = std::stod(argv[++i]);
+    } else if (arg == "--fan-in" && hasValue) {
+      options.fanIn = std::max<std::size_t>(std::stoull(argv[++i]), 1);
+    } else if (arg == "--reuse" && hasValue) {
+      options.reuse = std::stod(argv[++i]);
+    } else if (arg == "--error-at" && hasValue) {
+      options.errorAt = std::stoull(argv[++i]);
+    } else if (arg == "--wrong-conclusion") {
+      options.wrongConclusion = true;
+    } else if (arg == "--adversarial" && hasValue) {
+      options.adversarial = argv[++i];
+    } else if (arg == "--seed" && hasValue) {
+      options.seed = std::stoul(argv[++i]);
+    } else {
+      std::cerr << "Unknown option '" << arg << "'" << std::endl;
+      std::cerr << "Usage: " << argv[0] << " [--lines N] [--hypotheses N] [--variables N] [--formula-size N] [--depth N] [--axiom-share P] [--fan-in N] [--reuse P] [--error-at N] [--wrong-conclusion] [--adversarial right-nested|deep-chain|growing-chain] [--seed N]" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 1;
+  }
+  if (options.lines == 0) {
+    std::cerr << "A proof has at least one line" << std::endl;
+    return 1;
+  }
+  Proof proof;
+  if (options.adversarial) {
+    auto adversarial = AdversarialProof(options);
+    if (!adversarial) {
+      std::cerr << "Unknown kind of the adversarial proof '" << *options.adversarial << "'" << std::endl;
+      return 1;
+    }
+    proof = std::move(*adversarial);
+  } else {
+    proof = RandomProof{options}.Generate();
+  }
+
+  if (options.errorAt && 1 <= *options.errorAt && *options.errorAt <= proof.lines.size()) {
+    // the lines before it don't depend on it, so it is the first incorrect one
+    proof.lines[*options.errorAt - 1] = UNPROVABLE;
+  }
+
+  OutputWriter output{STDOUT_FILENO};
+  for (std::size_t i = 0; i < proof.hypotheses.size(); i++) {
+    output << (i == 0 ? "" : ",") << proof.hypotheses[i];
+  }
+  output << "|-";
+  if (options.wrongConclusion) {
+    output << "(" << proof.lines.back() << ")&" << UNPROVABLE;
+  } else {
+    output << proof.lines.back();
+  }
+  output << "\n";
+  for (const auto& line : proof.lines) {
+    output << line << "\n";
+  }
+  return 0;
+}
@@ -4,7 +4,7 @@ make clean
 
 make ut
 echo Running unit tests
-for i in test_parser test_semantic test_tokenizer; do
+for i in test_parser test_semantic test_tokenizer test_rules test_printing test_answer test_id_map; do
     echo Running $i
     if ./$i; then
         echo ====SUCCESS====
@@ -49,4 +49,226 @@ for i in negative/*.in; do
         exit 1
     fi
 done
-rm -f temp
+echo Running differential tests
+touch temp_mode
+for mode in --regular-parser --stream "--threads 4"; do
+    for i in positive/*.in negative/*.in; do
+        echo Running differential test $i with $mode
+        ./b_debug <$i >temp
+        ./b_debug $mode <$i >temp_mode
+        if cmp -s temp temp_mode; then
+            echo ====SUCCESS====
+        else
+            echo "====FAILURE====(output differs with $mode)"
+            exit 1
+        fi
+    done
+done
+for mode in "" "--threads 4"; do
+    echo Running a malformed line $mode
+    printf 'A|-A\nA->\n' >temp_mode
+    if ! ./b_debug $mode <temp_mode >temp 2>&1 && grep -q "Token expected" temp; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(the parse error is not reported with $mode)"
+        exit 1
+    fi
+done
+echo Running DAG round-trip tests
+make expand
+for i in positive/*.in negative/*.in; do
+    echo Running DAG round-trip test $i
+    ./b_debug <$i >temp
+    ./b_debug --dag <$i | ./expand >temp_mode
+    if cmp -s temp temp_mode; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(expanded DAG differs)"
+        exit 1
+    fi
+done
+echo Running a DAG with an out of range child
+printf 'dag 1\n0 Ax - A\n1 Ax - A\n2 E - A 18446744073709551617\n' >temp
+if ./expand <temp >temp_mode 2>/dev/null; then
+    echo "====FAILURE====(a child number that wraps around is accepted)"
+    exit 1
+else
+    echo ====SUCCESS====
+fi
+echo Running minimization tests
+for i in positive/*.in negative/*.in; do
+    echo Running minimization test $i
+    ./b_debug <$i >temp
+    ./b_debug --minimize <$i >temp_mode
+    if grep -q '^\[' temp; then
+        # the minimized proof must be correct and not longer
+        ./b_debug <temp_mode >temp
+        if grep -q '^\[' temp && [ "$(wc -l <temp_mode)" -le "$(wc -l <$i)" ]; then
+            echo ====SUCCESS====
+        else
+            echo "====FAILURE====(minimized proof is wrong)"
+            exit 1
+        fi
+    elif cmp -s temp temp_mode; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(error differs with --minimize)"
+        exit 1
+    fi
+done
+echo Running batch tests
+rm -rf temp_batch
+mkdir temp_batch
+for i in positive/*.in negative/*.in; do
+    cp $i temp_batch/$(dirname $i)_$(basename $i)
+done
+if ./b_debug --batch temp_batch --threads 4 >temp; then
+    echo ====SUCCESS====
+else
+    echo "====FAILURE====(batch failed)"
+    exit 1
+fi
+for i in positive/*.in negative/*.in; do
+    echo Running batch test $i
+    ./b_debug <$i >temp
+    if cmp -s temp temp_batch/$(dirname $i)_$(basename $i).result; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(output differs with --batch)"
+        exit 1
+    fi
+done
+echo Running a batch with a malformed statement
+printf 'A,B A\nA\n' >temp_batch/malformed.in
+if ! ./b_debug --batch temp_batch >temp 2>temp_mode && grep -q "malformed.in: failed (Turnstile expected, 'A' got)" temp && [ ! -s temp_mode ]; then
+    echo ====SUCCESS====
+else
+    echo "====FAILURE====(the statement error is not reported with --batch)"
+    exit 1
+fi
+rm -rf temp_batch
+echo Running stats tests
+for i in positive/*.in negative/*.in; do
+    for mode in "" --regular-parser; do
+        echo Running stats test $i $mode
+        ./b_debug $mode <$i >temp
+        ./b_debug --stats $mode <$i >temp_mode 2>temp_stats
+        if cmp -s temp temp_mode && grep -q "\"output\": {\"lines\": $(wc -l <temp), \"bytes\": $(wc -c <temp)}}" temp_stats; then
+            echo ====SUCCESS====
+        else
+            echo "====FAILURE====(wrong output or stats with --stats)"
+            exit 1
+        fi
+    done
+done
+rm -f temp_stats
+echo Running daemon tests
+rm -f temp_socket
+./b_debug --daemon temp_socket --threads 2 --max-interned 1000 2>/dev/null &
+daemon=$!
+while [ ! -S temp_socket ]; do sleep 0.1; done
+for i in positive/*.in negative/*.in; do
+    echo Running daemon test $i
+    ./b_debug <$i >temp
+    ./b_debug --connect temp_socket <$i >temp_mode
+    if cmp -s temp temp_mode; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(output differs with --daemon)"
+        kill $daemon
+        exit 1
+    fi
+done
+kill $daemon
+if wait $daemon && [ ! -e temp_socket ]; then
+    echo ====SUCCESS====
+else
+    echo "====FAILURE====(daemon did not stop cleanly)"
+    exit 1
+fi
+echo Running daemon error tests
+./b_debug --daemon temp_socket --threads 1 --idle-timeout 1 --max-input-bytes 1000 2>/dev/null &
+daemon=$!
+while [ ! -S temp_socket ]; do sleep 0.1; done
+printf 'A,B A\nA\n' >temp_malformed
+awk 'BEGIN { print "A|-A"; for (i = 0; i < 500; i++) print "A" }' >temp_large
+for i in temp_malformed temp_large negative/*.in; do
+    echo Running daemon error test $i
+    ./b_debug --max-input-bytes 1000 <$i >temp 2>temp_errors
+    code=$?
+    ./b_debug --connect temp_socket <$i >temp_mode 2>temp_errors_mode
+    if [ $? -eq $code ] && cmp -s temp temp_mode && cmp -s temp_errors temp_errors_mode; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(output, errors or exit code differ with --daemon)"
+        kill $daemon
+        exit 1
+    fi
+done
+echo Running an idle daemon client
+sleep 3 | ./b_debug --connect temp_socket >/dev/null 2>temp_errors &
+client=$!
+sleep 0.5
+./b_debug <positive/01.in >temp
+# the only worker is freed when the idle client times out
+if ./b_debug --connect temp_socket <positive/01.in >temp_mode && cmp -s temp temp_mode && ! wait $client && grep -q "Failed to read the input" temp_errors; then
+    echo ====SUCCESS====
+else
+    echo "====FAILURE====(an idle client is not dropped by --idle-timeout)"
+    kill $daemon
+    exit 1
+fi
+kill $daemon
+wait $daemon
+rm -f temp_malformed temp_large temp_errors temp_errors_mode
+echo Running deep nesting tests
+touch temp_deep
+awk 'BEGIN { print "A,A->A|-A"; print "A"; for (i = 0; i < 100000; i++) { print "A->A"; print "A" } }' >temp_deep
+for mode in "" --regular-parser; do
+    echo Running a long modus ponens chain $mode
+    if ./b_debug $mode <temp_deep >temp && tail -n 1 temp | grep -q '^\[0\] A,(A)->(A)|-A \[E->\]$'; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(deep proof tree)"
+        exit 1
+    fi
+done
+echo Running minimization of a long modus ponens chain
+if [ "$(./b_debug --minimize <temp_deep | tail -n +2)" = "A" ]; then
+    echo ====SUCCESS====
+else
+    echo "====FAILURE====(the hypothesis is the shallowest justification)"
+    exit 1
+fi
+awk 'BEGIN { s = "A"; for (i = 0; i < 100000; i++) s = "(!" s ")->A"; print s "|-" s; print s }' >temp_deep
+for mode in "" --regular-parser; do
+    echo Running a deeply nested formula $mode
+    if ./b_debug $mode <temp_deep >temp && grep -q '^\[0\] .* \[Ax\]$' temp; then
+        echo ====SUCCESS====
+    else
+        echo "====FAILURE====(deep formula)"
+        exit 1
+    fi
+done
+echo Running generated proofs
+make gen
+for seed in 1 2 3; do
+    for args in "--hypotheses 0" "--fan-in 4 --reuse 0.1" "--formula-size 10 --depth 3 --axiom-share 0.8" "--adversarial right-nested --depth 200" "--adversarial growing-chain"; do
+        echo Running a generated proof $args --seed $seed
+        ./gen --lines 300 --seed $seed $args >temp_deep
+        if ./b_debug <temp_deep >temp && ! grep -q -e 'Proof is incorrect at line' -e 'The proof does not prove the required expression' temp; then
+            echo ====SUCCESS====
+        else
+            echo "====FAILURE====(a generated proof is not converted)"
+            exit 1
+        fi
+        ./gen --lines 300 --seed $seed --error-at $((seed * 70)) $args >temp_deep
+        if [ "$(./b_debug <temp_deep)" = "Proof is incorrect at line $((seed * 70 + 1))" ]; then
+            echo ====SUCCESS====
+        else
+            echo "====FAILURE====(the error of a generated proof is not found)"
+            exit 1
+        fi
+    done
+done
+rm -f temp temp_mode temp_deep
@@ -0,0 +1,122 @@
+#include "expression_calculus/answer.h"
+#include "expression_calculus/checker.h"
+#include "expression_calculus/expression.h"
+#include "expression_calculus/parsing.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ASSERT_EQUAL(x, y) \
+  if ((x) != (y)) { std::cerr << "Failed condition " #x " == " #y << std::endl; std::abort(); }
+
+struct Test {
+public:
+  // `proof` is the input of the program: the statement and the lines
+  Test(std::string name, const std::string& proof) {
+    std::cout << "Testing " << name << "..." << std::flush;
+    std::istringstream is{proof};
+    std::string line;
+    std::getline(is, line);
+    std::vector<Rules::TPtr> hypotheses;
+    SemanticParser statement{line};
+    if (!statement.ParseToken(TokenType::TURNSTILE)) {
+      do {
+        hypotheses.push_back(statement.ParseSemantic());
+      } while (statement.ParseToken(TokenType::COMMA));
+      ASSERT_EQUAL(statement.ParseToken(TokenType::TURNSTILE), true);
+    }
+    ProofChecker checker{hypotheses};
+    Rules::TPtr last;
+    while (std::getline(is, line)) {
+      last = SemanticParser{line}.ParseSemantic();
+      ASSERT_EQUAL(checker.AddLine(last), true);
+    }
+
+    // the estimate must be exact, with any state of the render cache
+    for (std::size_t cacheLimit : {std::size_t{0}, RenderCache::DEFAULT_MEMORY_LIMIT}) {
+      RenderCache cache{cacheLimit};
+      auto size = EstimateAnswer(cache, hypotheses, checker.GetTree(last));
+      std::ostringstream os;
+      PrintAnswer(os, cache, hypotheses, checker.GetTree(last), 0);
+      const std::string answer = os.str();
+      ASSERT_EQUAL(size.bytes, answer.size());
+      ASSERT_EQUAL(size.lines, static_cast<std::uint64_t>(std::count(answer.begin(), answer.end(), '\n')));
+    }
+  }
+
+  ~Test() {
+    std::cout << "Done" << std::endl;
+  }
+};
+
+// A modus ponens chain: the tree of the last `A` is `steps` levels deep
+std::string Chain(std::size_t steps, const std::string& hypotheses) {
+  std::string proof = hypotheses + "|-A\nA\n";
+  for (std::size_t i = 0; i < steps; i++) {
+    proof += "A->A\nA\n";
+  }
+  return proof;
+}
+
+int main() {
+  Test{"a single hypothesis", "A|-A\nA\n"};
+  Test{"axioms without hypotheses",
+      "|-A->A->A\n"
+      "A -> B -> A\n"
+      "(A->B)->(A->B->C)->(A->C)\n"
+      "A -> B -> A & B\n"
+      "A & B -> A\n"
+      "A & B -> B\n"
+      "A -> A | B\n"
+      "B -> A | B\n"
+      "(A -> C) -> (B -> C) -> (A | B -> C)\n"
+      "(A->B)->(A->!B)->!A\n"
+      "A->!A->B\n"
+      "A->A->A\n"};
+  Test{"modus ponens with hypotheses",
+      "!A,!B|-!(A&B)\n"
+      "!B\n"
+      "(A&B->B)->(A&B->!B)->!(A&B)\n"
+      "A&B->B\n"
+      "!B->A&B->!B\n"
+      "A&B->!B\n"
+      "(A&B->!B)->!(A&B)\n"
+      "!(A&B)\n"};
+  // the depths cross the lengths of 1, 2 and 3 digits
+  Test{"a long chain", Chain(1000, "A,A->A")};
+  Test{"a long chain with an axiom",
+      "A|-A\nA\nA->(A->A)->A\n(A->A)->A\nA->A->A\nA->A\nA\n"};
+
+  {
+    std::cout << "Testing the counts saturate..." << std::flush;
+    // `B->B->B` waits for `B`, so the tree of `B->B` is rebuilt from the
+    // latest tree of `B` every time: every `B` uses the previous one twice and
+    // the tree has 2^70 leaves
+    std::string proof = "A,B,B->B->B|-B\nA\nB->B->B\nB\n";
+    for (int i = 0; i < 70; i++) {
+      proof += "B->B\nB\n";
+    }
+    std::istringstream is{proof};
+    std::string line;
+    std::getline(is, line);
+    std::vector<Rules::TPtr> hypotheses;
+    SemanticParser statement{line};
+    do {
+      hypotheses.push_back(statement.ParseSemantic());
+    } while (statement.ParseToken(TokenType::COMMA));
+    ProofChecker checker{hypotheses};
+    Rules::TPtr last;
+    while (std::getline(is, line)) {
+      last = SemanticParser{line}.ParseSemantic();
+      ASSERT_EQUAL(checker.AddLine(last), true);
+    }
+    RenderCache cache;
+    auto size = EstimateAnswer(cache, hypotheses, checker.GetTree(last));
+    ASSERT_EQUAL(size.bytes, AnswerSize::SATURATED);
+    std::cout << "Done" << std::endl;
+  }
+}
@@ -0,0 +1,89 @@
+#include "expression_calculus/expression.h"
+#include "expression_calculus/id_map.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#define ASSERT_EQUAL(x, y) \
+  if ((x) != (y)) { std::cerr << "Failed condition " #x " == " #y << std::endl; std::abort(); }
+
+int main() {
+  auto& arena = Semantic::Arena::Global();
+  std::mt19937 gen;
+  // variables and implications between them, so that the ids are not all
+  // consecutive
+  std::vector<std::shared_ptr<Semantic::Expression>> exprs;
+  for (int i = 0; i < 2000; i++) {
+    auto var = arena.MakeVariable("A" + std::to_string(i));
+    exprs.push_back(var);
+    if (i % 3 == 0) {
+      exprs.push_back(arena.MakeBinary(ExpressionType::IMPLICATION, var, exprs[gen() % exprs.size()]));
+    }
+  }
+
+  {
+    std::cout << "Testing the map against std::map..." << std::flush;
+    IdMap<std::size_t> map;
+    std::map<std::size_t, std::size_t> expected;
+    for (int t = 0; t < 20000; t++) {
+      const auto& expr = *exprs[gen() % exprs.size()];
+      const bool found = map.Find(expr) != nullptr;
+      ASSERT_EQUAL(found, expected.count(expr.id) > 0);
+      if (found) {
+        ASSERT_EQUAL(*map.Find(expr), expected[expr.id]);
+      }
+      if (gen() % 2 == 0) {
+        map[expr] += t;
+        expected[expr.id] += t;
+      }
+      ASSERT_EQUAL(map.Size(), expected.size());
+    }
+    for (const auto& expr : exprs) {
+      ASSERT_EQUAL(map.Contains(*expr), expected.count(expr->id) > 0);
+    }
+    std::cout << "Done" << std::endl;
+
+    std::cout << "Testing the retention of the odd values..." << std::flush;
+    const std::size_t memory = map.MemoryUsage();
+    map.Retain([] (std::size_t value) {
+      return value % 2 == 1;
+    });
+    for (auto it = expected.begin(); it != expected.end();) {
+      it = it->second % 2 == 1 ? std::next(it) : expected.erase(it);
+    }
+    ASSERT_EQUAL(map.Size(), expected.size());
+    for (const auto& expr : exprs) {
+      ASSERT_EQUAL(map.Contains(*expr), expected.count(expr->id) > 0);
+      if (map.Contains(*expr)) {
+        ASSERT_EQUAL(*map.Find(*expr), expected[expr->id]);
+      }
+    }
+    ASSERT_EQUAL(map.MemoryUsage() <= memory, true);
+    map.Retain([] (std::size_t) {
+      return false;
+    });
+    ASSERT_EQUAL(map.Size(), std::size_t{0});
+    ASSERT_EQUAL(map.Contains(*exprs.front()), false);
+    std::cout << "Done" << std::endl;
+  }
+
+  {
+    std::cout << "Testing the set..." << std::flush;
+    IdSet set;
+    for (const auto& expr : exprs) {
+      ASSERT_EQUAL(set.Insert(*expr), true);
+    }
+    for (const auto& expr : exprs) {
+      ASSERT_EQUAL(set.Insert(*expr), false);
+      ASSERT_EQUAL(set.Contains(*expr), true);
+    }
+    ASSERT_EQUAL(set.Size(), exprs.size());
+    ASSERT_EQUAL(set.Contains(*arena.MakeVariable("B")), false);
+    std::cout << "Done" << std::endl;
+  }
+}
@@ -0,0 +1,100 @@
+#include "expression_calculus/expression.h"
+#include "expression_calculus/parsing.h"
+#include "expression_calculus/printing.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ASSERT_EQUAL(x, y) \
+  if ((x) != (y)) { std::cerr << "Failed condition " #x " == " #y << std::endl; std::abort(); }
+
+// A random tree with at most `depth` levels, built from a few variables so that
+// the subexpressions repeat
+std::shared_ptr<Semantic::Expression> RandomExpression(std::mt19937& gen, std::size_t depth) {
+  auto& arena = Semantic::Arena::Global();
+  const auto coin = [&gen] (int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+  if (depth == 0 || coin(4) == 0) {
+    if (coin(8) == 0) {
+      return arena.MakeBottom();
+    }
+    return arena.MakeVariable(std::string(1, static_cast<char>('A' + coin(3))));
+  }
+  static const ExpressionType types[] = {ExpressionType::IMPLICATION, ExpressionType::DISJUNCTION, ExpressionType::CONJUNCTION};
+  auto lhs = RandomExpression(gen, depth - 1);
+  auto rhs = RandomExpression(gen, depth - 1);
+  return arena.MakeBinary(types[coin(3)], lhs, rhs);
+}
+
+std::string Rendered(const Semantic::Expression& expr) {
+  std::ostringstream os;
+  PrintExpression(os, expr);
+  return os.str();
+}
+
+std::string Rendered(RenderCache& cache, const Semantic::Expression& expr) {
+  std::ostringstream os;
+  cache.Print(os, expr);
+  return os.str();
+}
+
+struct Test {
+public:
+  Test(std::string exprStr, std::string expected) {
+    std::cout << "Testing '" << exprStr << "'..." << std::flush;
+    auto expr = SemanticParser{exprStr}.ParseSemantic();
+    ASSERT_EQUAL(Rendered(*expr), expected);
+    RenderCache cache;
+    ASSERT_EQUAL(Rendered(cache, *expr), expected);
+    // the second time the text is copied
+    ASSERT_EQUAL(Rendered(cache, *expr), expected);
+  }
+
+  ~Test() {
+    std::cout << "Done" << std::endl;
+  }
+};
+
+int main() {
+  Test{"A", "A"};
+  Test{"!A", "(A)->(_|_)"};
+  Test{"A->B->C", "(A)->((B)->(C))"};
+  Test{"A|B&C", "(A)|((B)&(C))"};
+  Test{"(A->A)&(A->A)", "((A)->(A))&((A)->(A))"};
+
+  {
+    std::cout << "Testing the subexpressions are rendered in place..." << std::flush;
+    RenderCache cache;
+    auto expr = SemanticParser{"(A->B)&(A->B)|C"}.ParseSemantic();
+    Rendered(cache, *expr);
+    // (A->B)&(A->B)|C, (A->B)&(A->B), A->B, A, B, C
+    ASSERT_EQUAL(cache.Size(), 6u);
+    ASSERT_EQUAL(Rendered(cache, *SemanticParser{"A->B"}.ParseSemantic()), "(A)->(B)");
+    ASSERT_EQUAL(cache.Size(), 6u);
+    std::cout << "Done" << std::endl;
+  }
+
+  // The cached texts must be the same as the direct rendering, with any memory
+  // limit (the expressions that don't fit are printed directly)
+  for (std::size_t limit : {std::size_t{0}, std::size_t{1} << 10, std::size_t{1} << 14, RenderCache::DEFAULT_MEMORY_LIMIT}) {
+    std::cout << "Testing random expressions with the memory limit " << limit << "..." << std::flush;
+    std::mt19937 gen{static_cast<std::mt19937::result_type>(limit + 1)};
+    RenderCache cache{limit};
+    std::vector<std::shared_ptr<Semantic::Expression>> expressions;
+    for (int i = 0; i < 1000; i++) {
+      expressions.push_back(RandomExpression(gen, 7));
+    }
+    for (int pass = 0; pass < 2; pass++) {
+      for (const auto& expr : expressions) {
+        ASSERT_EQUAL(Rendered(cache, *expr), Rendered(*expr));
+      }
+    }
+    if (limit < RenderCache::DEFAULT_MEMORY_LIMIT) {
+      ASSERT_EQUAL(cache.MemoryUsage() <= limit, true);
+    }
+    std::cout << "Done" << std::endl;
+  }
+}
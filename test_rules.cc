@@ -0,0 +1,85 @@
+#include "expression_calculus/expression.h"
+#include "expression_calculus/parsing.h"
+#include "expression_calculus/patterns.h"
+#include "expression_calculus/rules.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#define ASSERT_EQUAL(x, y) \
+  if ((x) != (y)) { std::cerr << "Failed condition " #x " == " #y << std::endl; std::abort(); }
+
+using TMatcher = bool(*)(const Semantic::Expression*);
+
+const TMatcher matchers[] = {
+  Rules::MatchAx1, Rules::MatchAx2, Rules::MatchAx3, Rules::MatchAx4, Rules::MatchAx5,
+  Rules::MatchAx6, Rules::MatchAx7, Rules::MatchAx8, Rules::MatchAx9, Rules::MatchAx10,
+};
+
+struct Test {
+public:
+  // `schemes` is the list of axiom schemes (1-based) the expression is an
+  // instance of
+  Test(std::string exprStr, std::vector<std::size_t> schemes) {
+    std::cout << "Testing '" << exprStr << "'..." << std::flush;
+    auto expr = SemanticParser{exprStr}.ParseSemantic();
+    for (std::size_t i = 0; i < std::size(matchers); i++) {
+      bool expected = std::find(schemes.begin(), schemes.end(), i + 1) != schemes.end();
+      if (matchers[i](expr.get()) != expected) {
+        std::cerr << "Axiom " << i + 1 << (expected ? " expected" : " not expected") << std::endl;
+        std::abort();
+      }
+    }
+    auto firstScheme = schemes.empty() ? Rules::NOT_AN_AXIOM : *std::min_element(schemes.begin(), schemes.end());
+    ASSERT_EQUAL(Rules::ClassifyAxiom(expr.get()), firstScheme);
+  }
+
+  ~Test() {
+    std::cout << "Done" << std::endl;
+  }
+};
+
+int main() {
+  Test{"A->B->A", {1}};
+  Test{"(A->B)->(C->B)->(A->B)", {1}};
+  Test{"A->B->C", {}};
+  Test{"(A->B)->(A->B->C)->(A->C)", {2}};
+  Test{"(A->B)->(A->C->C)->(A->C)", {}};
+  Test{"A->B->A&B", {3}};
+  Test{"A->B->B&A", {}};
+  Test{"A&B->A", {4}};
+  Test{"A&B->B", {5}};
+  Test{"A&A->A", {4, 5}};
+  Test{"A->A|B", {6}};
+  Test{"B->A|B", {7}};
+  Test{"A->A|A", {6, 7}};
+  Test{"(A->C)->(B->C)->(A|B->C)", {8}};
+  Test{"(A->C)->(B->C)->(B|A->C)", {}};
+  Test{"(A->B)->(A->!B)->!A", {2, 9}};
+  Test{"(A->B)->(A->!B)->!B", {}};
+  Test{"A->!A->B", {10}};
+  Test{"A->!A->A", {1, 10}};
+  Test{"A->!B->C", {}};
+  Test{"A&B->A|C", {}};
+  Test{"A&(A->!B)->(A->!B)", {5}};
+  Test{"((A->B)->C)->(A->B)->C", {}};
+  Test{"A", {}};
+  Test{"!A", {}};
+
+  {
+    using namespace Semantic::Patterns;
+    std::cout << "Testing bindings..." << std::flush;
+    auto expr = SemanticParser{"(P->Q)->(P->Q->R)->(P->R)"}.ParseSemantic();
+    Bindings bindings;
+    ASSERT_EQUAL((Match<Impl<Impl<Any<0>, Any<1>>, Any<2>>>(expr.get(), bindings)), true);
+    ASSERT_EQUAL(bindings[0], SemanticParser{"P"}.ParseSemantic().get());
+    ASSERT_EQUAL(bindings[1], SemanticParser{"Q"}.ParseSemantic().get());
+    ASSERT_EQUAL(bindings[2], SemanticParser{"(P->Q->R)->(P->R)"}.ParseSemantic().get());
+    ASSERT_EQUAL((Match<Impl<Any<0>, Any<0>>>(expr.get())), false);
+    ASSERT_EQUAL((Match<Or<Any<0>, Any<1>>>(expr.get())), false);
+    std::cout << "Done" << std::endl;
+  }
+}
@@ -3,6 +3,11 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 // TODO: variadic getter that returns optional (or throws an exception idk, the
 // error messages should be easily diagnosible)
@@ -17,6 +22,12 @@ public:
     auto parser = std::make_unique<Parser>(exprStr);
     expr = parser->ParseExpression();
     owningExpr = std::make_unique<Semantic::OwningExpression>(expr.get());
+    // The single pass parser must build exactly the same (interned) tree
+    SemanticParser semanticParser{exprStr};
+    if (semanticParser.ParseSemantic() != owningExpr->root || !semanticParser.IsExhausted()) {
+      std::cerr << "SemanticParser disagrees with Parser" << std::endl;
+      std::abort();
+    }
   }
 
   const Regular::Expression* GetExpr() const {
@@ -27,6 +38,10 @@ public:
     return owningExpr->expressionString;
   }
 
+  const Semantic::Expression* GetRoot() const {
+    return owningExpr->root.get();
+  }
+
   ~Test() {
     std::cout << "Done" << std::endl;
   }
@@ -36,6 +51,156 @@ private:
   std::unique_ptr<Semantic::OwningExpression> owningExpr;
 };
 
+// Generates a random expression string with random redundant parentheses and
+// whitespace. Returns the expected tree and the precedence of the top-level
+// operation of the string (0 for ->, 1 for |, 2 for &, 3 for the rest)
+std::pair<std::shared_ptr<Semantic::Expression>, int> RandomExpression(std::mt19937& gen, std::size_t depth, std::string& out) {
+  auto& arena = Semantic::Arena::Global();
+  const auto coin = [&gen] (int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+  const auto space = [&] () { out.append(coin(3) == 0 ? " " : ""); };
+  const auto operand = [&] (int minPrecedence) {
+    std::string sub;
+    auto [tree, precedence] = RandomExpression(gen, depth - 1, sub);
+    if (precedence < minPrecedence || coin(4) == 0) {
+      out.append("(");
+      space();
+      out.append(sub);
+      space();
+      out.append(")");
+    } else {
+      out.append(sub);
+    }
+    space();
+    return tree;
+  };
+  if (depth == 0 || coin(4) == 0) {
+    std::string name(1, static_cast<char>('A' + coin(3)));
+    if (coin(2) == 0) {
+      name += "'";
+    }
+    out.append(name);
+    return {arena.MakeVariable(name), 3};
+  }
+  static const std::string ops[] = {"->", "|", "&"};
+  static const ExpressionType types[] = {ExpressionType::IMPLICATION, ExpressionType::DISJUNCTION, ExpressionType::CONJUNCTION};
+  const int op = coin(4);
+  if (op == 3) {
+    out.append("!");
+    space();
+    auto tree = operand(3);
+    return {arena.MakeBinary(ExpressionType::IMPLICATION, tree, arena.MakeBottom()), 3};
+  }
+  // -> is right-associative, | and & are left-associative
+  auto lhs = operand(op == 0 ? 1 : op + 1);
+  out.append(ops[op]);
+  space();
+  auto rhs = operand(op == 0 ? 0 : op + 2);
+  return {arena.MakeBinary(types[op], lhs, rhs), op};
+}
+
+// The recursive descent the parsers used before `ParseInfix`, kept as an
+// independent reference for the random tests. It recurses once per nesting
+// level, which is fine for the short random lines
+class ReferenceParser {
+public:
+  ReferenceParser(std::string expressionLine) : tokenizer{std::move(expressionLine)} {}
+
+  std::shared_ptr<Semantic::Expression> ParseExpression() {
+    // implication is right-associative
+    auto lhs = ParseDisjunctionSequence();
+    if (!ParseToken(TokenType::ARROW)) {
+      return lhs;
+    }
+    auto rhs = ParseExpression();
+    return arena.MakeBinary(ExpressionType::IMPLICATION, lhs, rhs);
+  }
+
+  std::string_view PeekToken() {
+    auto token = tokenizer.Peek();
+    return token ? token->second : "";
+  }
+
+private:
+  bool ParseToken(TokenType tokenType) {
+    if (tokenizer.Peek() && tokenizer.Peek()->first == tokenType) {
+      tokenizer.NextToken();
+      return true;
+    }
+    return false;
+  }
+
+  std::shared_ptr<Semantic::Expression> ParsePrim() {
+    if (!tokenizer.Peek()) {
+      throw std::runtime_error{"Token expected at the beginning of expression primitive"};
+    }
+    auto [tokenType, token] = *tokenizer.NextToken();
+    switch (tokenType) {
+      case TokenType::LPAREN: {
+        auto expr = ParseExpression();
+        if (auto rparen = tokenizer.NextToken(); !rparen || rparen->first != TokenType::RPAREN) {
+          throw std::runtime_error{std::string{"Closing parenthesis expected, got "} + (rparen ? std::string{rparen->second} : "no tokens")};
+        }
+        return expr;
+      }
+      case TokenType::VARIABLE:
+        return arena.MakeVariable(token);
+      case TokenType::EXCLAMATION: {
+        auto operand = ParsePrim();
+        return arena.MakeBinary(ExpressionType::IMPLICATION, operand, arena.MakeBottom());
+      }
+      default:
+        throw std::runtime_error{"Unexpected token at the start of primary expression"};
+    }
+  }
+
+  std::shared_ptr<Semantic::Expression> ParseConjunctionSequence() {
+    auto result = ParsePrim();
+    while (ParseToken(TokenType::AMPERSAND)) {
+      auto rhs = ParsePrim();
+      result = arena.MakeBinary(ExpressionType::CONJUNCTION, result, rhs);
+    }
+    return result;
+  }
+
+  std::shared_ptr<Semantic::Expression> ParseDisjunctionSequence() {
+    auto result = ParseConjunctionSequence();
+    while (ParseToken(TokenType::BAR)) {
+      auto rhs = ParseConjunctionSequence();
+      result = arena.MakeBinary(ExpressionType::DISJUNCTION, result, rhs);
+    }
+    return result;
+  }
+
+  Tokenizer tokenizer;
+  Semantic::Arena& arena = Semantic::Arena::Global();
+};
+
+// What `parse(parser)` gives: the tree and the token it stopped at, or the
+// error
+template<typename TParser, typename TParse>
+std::string Outcome(TParser& parser, TParse parse) {
+  try {
+    auto tree = parse(parser);
+    return "expression " + std::to_string(tree->id) + " before '" + std::string{parser.PeekToken()} + "'";
+  } catch (const std::runtime_error& e) {
+    return std::string{"error: "} + e.what();
+  }
+}
+
+// A random sequence of tokens, which is rarely a well-formed expression
+std::string RandomTokens(std::mt19937& gen, std::size_t maxTokens) {
+  static const char* tokens[] = {"A", "B'", "!", "(", ")", "&", "|", "->", "(", "A"};
+  const auto coin = [&gen] (int n) { return std::uniform_int_distribution<>(0, n - 1)(gen); };
+  std::string out;
+  const int count = 1 + coin(static_cast<int>(maxTokens));
+  for (int i = 0; i < count; i++) {
+    out.append(tokens[coin(std::size(tokens))]);
+    // (adjacent variables must be separated)
+    out.append(" ");
+  }
+  return out;
+}
+
 int main() {
   {
     Test t{"A"};
@@ -76,5 +241,142 @@ int main() {
     Test t{"(A->B)->(A->B->C)->(A->C)"};
     ASSERT_EQUAL(t.GetPrefixView(), "-> -> A B -> -> A -> B C -> A C");
   }
-}
 
+  {
+    // Equal subexpressions are interned into the same node
+    using namespace Semantic;
+    Test t1{"(A->B)->(A->B)"};
+    Test t2{"A->B"};
+    ASSERT_EQUAL(GetComponent<Expression>(t1.GetRoot(), &Implication::left), t2.GetRoot());
+    ASSERT_EQUAL(GetComponent<Expression>(t1.GetRoot(), &Implication::right), t2.GetRoot());
+    ASSERT_EQUAL(GetComponent<Expression>(t1.GetRoot(), &Implication::left, &Implication::left)->id,
+                 GetComponent<Expression>(t2.GetRoot(), &Implication::left)->id);
+  }
+
+  {
+    using namespace Semantic;
+    Test t1{"!A"};
+    Test t2{"!(B->C)"};
+    Test t3{"A->B"};
+    ASSERT_EQUAL(GetComponent<Bottom>(t1.GetRoot(), &Implication::right), GetComponent<Bottom>(t2.GetRoot(), &Implication::right));
+    ASSERT_EQUAL((*t1.GetRoot() == *t3.GetRoot()), false);
+  }
+
+  {
+    Test t{"A|B&C"};
+    ASSERT_EQUAL(t.GetPrefixView(), "| A & B C");
+  }
+
+  {
+    Test t{"A&B|C&D|E"};
+    ASSERT_EQUAL(t.GetPrefixView(), "| | & A B & C D E");
+  }
+
+  {
+    Test t{"!A&B->C"};
+    ASSERT_EQUAL(t.GetPrefixView(), "-> & -> A _|_ B C");
+  }
+
+  {
+    constexpr std::size_t ITERATIONS = 1'000;
+    std::cout << "Testing random expressions (" << ITERATIONS << " iterations)..." << std::flush;
+    std::mt19937 gen;
+    for (std::size_t i = 0; i < ITERATIONS; i++) {
+      std::string exprStr;
+      auto expected = RandomExpression(gen, 6, exprStr).first;
+      SemanticParser semanticParser{exprStr};
+      ASSERT_EQUAL(semanticParser.ParseSemantic(), expected);
+      ASSERT_EQUAL(Parser{exprStr}.ParseSemantic(), expected);
+      ASSERT_EQUAL(ReferenceParser{exprStr}.ParseExpression(), expected);
+    }
+    std::cout << "Done" << std::endl;
+  }
+
+  {
+    // Both parsers stop at the same token or throw the same error as the
+    // recursive descent
+    constexpr std::size_t ITERATIONS = 10'000;
+    std::cout << "Testing random token sequences (" << ITERATIONS << " iterations)..." << std::flush;
+    std::mt19937 gen;
+    for (std::size_t i = 0; i < ITERATIONS; i++) {
+      const std::string line = RandomTokens(gen, 12);
+      ReferenceParser reference{line};
+      const std::string expected = Outcome(reference, [] (ReferenceParser& p) { return p.ParseExpression(); });
+      SemanticParser semanticParser{line};
+      Parser parser{line};
+      const std::string semantic = Outcome(semanticParser, [] (SemanticParser& p) { return p.ParseSemantic(); });
+      const std::string regular = Outcome(parser, [] (Parser& p) { return p.ParseSemantic(); });
+      if (semantic != expected || regular != expected) {
+        std::cerr << "'" << line << "': " << expected << " expected, SemanticParser: " << semantic << ", Parser: " << regular << std::endl;
+        std::abort();
+      }
+    }
+    std::cout << "Done" << std::endl;
+  }
+
+  {
+    // The hashes are structural: they don't depend on the arena nor on the
+    // order in which the expressions were interned
+    std::cout << "Testing structural hashes..." << std::flush;
+    Semantic::Arena arena;
+    std::string line1 = "B->A";
+    std::string line2 = "(A->B)->(B->A)";
+    auto t1 = SemanticParser{line1, arena}.ParseSemantic();
+    auto t2 = SemanticParser{line2, arena}.ParseSemantic();
+    auto g1 = SemanticParser{line1}.ParseSemantic();
+    auto g2 = SemanticParser{line2}.ParseSemantic();
+    ASSERT_EQUAL(t1->memoizedHash, g1->memoizedHash);
+    ASSERT_EQUAL(t2->memoizedHash, g2->memoizedHash);
+    auto lhs = Semantic::GetComponent<Semantic::Expression>(t2.get(), &Semantic::Implication::left);
+    ASSERT_EQUAL((lhs->memoizedHash == t1->memoizedHash), false);
+    ASSERT_EQUAL(arena.CollectHashReport().expressions, 6);  // including _|_
+    ASSERT_EQUAL(arena.CollectHashReport().distinctHashes, 6);
+    std::cout << "Done" << std::endl;
+  }
+
+  {
+    // Interning from several threads at once yields the same nodes
+    constexpr std::size_t THREADS = 4;
+    constexpr std::size_t EXPRESSIONS = 300;
+    std::cout << "Testing concurrent interning (" << THREADS << " threads)..." << std::flush;
+    std::vector<std::string> exprStrs;
+    std::mt19937 gen{42};
+    for (std::size_t i = 0; i < EXPRESSIONS; i++) {
+      RandomExpression(gen, 6, exprStrs.emplace_back());
+    }
+    Semantic::Arena arena;
+    std::vector<std::vector<std::shared_ptr<Semantic::Expression>>> results(THREADS);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < THREADS; t++) {
+      threads.emplace_back([&, t] {
+        for (const auto& exprStr : exprStrs) {
+          results[t].push_back(SemanticParser{exprStr, arena}.ParseSemantic());
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (std::size_t t = 1; t < THREADS; t++) {
+      ASSERT_EQUAL(results[t], results[0]);
+    }
+    std::cout << "Done" << std::endl;
+  }
+
+  {
+    // A cleared arena interns the expressions anew, under new ids
+    std::cout << "Testing the clearing of the arena..." << std::flush;
+    Semantic::Arena arena;
+    auto before = SemanticParser{"A->B&!A", arena}.ParseSemantic();
+    const std::size_t size = arena.Size();
+    arena.Clear();
+    ASSERT_EQUAL(arena.BinariesCount(), 0);
+    ASSERT_EQUAL(arena.CollectHashReport().expressions, 1);  // _|_
+    auto after = SemanticParser{"A->B&!A", arena}.ParseSemantic();
+    ASSERT_EQUAL(after->memoizedHash, before->memoizedHash);
+    ASSERT_EQUAL((after->id >= size), true);
+    ASSERT_EQUAL((after == SemanticParser{"A->B&!A", arena}.ParseSemantic()), true);
+    ASSERT_EQUAL(arena.CollectHashReport().expressions, 6);
+    std::cout << "Done" << std::endl;
+  }
+}
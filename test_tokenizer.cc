@@ -25,6 +25,19 @@ public:
         std::cout << "Mismatch!" << std::endl;
         std::abort();
       }
+      // the non-owning tokenizer must yield the same tokens, pointing right
+      // into the line
+      Tokenizer view{std::string_view{exprStr}, Tokenizer::NonOwning{}};
+      for (const auto& [tokenType, token] : view.GetTokens()) {
+        if (token.data() < exprStr.data() || token.data() + token.size() > exprStr.data() + exprStr.size()) {
+          std::cout << "Token outside of the line!" << std::endl;
+          std::abort();
+        }
+      }
+      if (Parser{std::make_unique<Tokenizer>(exprStr, Tokenizer::NonOwning{})}.GetTokens() != tokens) {
+        std::cout << "Non-owning mismatch!" << std::endl;
+        std::abort();
+      }
     };
 
     if (withoutSpaces) {
@@ -0,0 +1,159 @@
+#include "input.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void ThrowTooLong(std::size_t limit) {
+  throw std::length_error{"The input is longer than " + std::to_string(limit) + " bytes"};
+}
+
+}  // namespace
+
+LineReader::LineReader(int inputFd, std::size_t maxBytes) : fd{inputFd}, limit{maxBytes} {
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, st.st_size, MADV_SEQUENTIAL);
+      mapped = true;
+      exhausted = true;
+      data = static_cast<const char*>(addr);
+      mappedSize = st.st_size;
+      // the lines before the current position of the descriptor were already
+      // consumed by someone else
+      off_t offset = lseek(fd, 0, SEEK_CUR);
+      pos = offset > 0 ? std::min<std::size_t>(offset, mappedSize) : 0;
+      end = mappedSize;
+      if (end - pos > limit) {
+        munmap(addr, mappedSize);
+        ThrowTooLong(limit);
+      }
+      return;
+    }
+  }
+  buffer.resize(BLOCK_SIZE);
+  data = buffer.data();
+}
+
+LineReader::~LineReader() {
+  if (mapped) {
+    munmap(const_cast<char*>(data), mappedSize);
+  }
+}
+
+void LineReader::Refill() {
+  if (exhausted || std::memchr(data + pos, '\n', end - pos) != nullptr) {
+    return;
+  }
+  // drop the lines that don't need to be kept
+  std::memmove(buffer.data(), buffer.data() + keep, end - keep);
+  end -= keep;
+  pos -= keep;
+  keep = 0;
+  while (true) {
+    if (end == buffer.size()) {
+      // the lines don't fit
+      buffer.resize(buffer.size() * 2);
+    }
+    ssize_t count = read(fd, buffer.data() + end, buffer.size() - end);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(), "Failed to read the input"};
+    }
+    data = buffer.data();
+    if (count == 0) {
+      exhausted = true;
+      return;
+    }
+    readBytes += count;
+    if (readBytes > limit) {
+      ThrowTooLong(limit);
+    }
+    const char* newData = data + end;
+    end += count;
+    if (std::memchr(newData, '\n', count) != nullptr) {
+      return;
+    }
+  }
+}
+
+std::optional<std::pair<std::size_t, std::size_t>> LineReader::TakeLine() {
+  Refill();
+  if (pos == end) {
+    return std::nullopt;
+  }
+  const std::size_t begin = pos;
+  auto newline = static_cast<const char*>(std::memchr(data + pos, '\n', end - pos));
+  if (newline == nullptr) {
+    // the last line is not terminated
+    pos = end;
+    return std::make_pair(begin - keep, end - begin);
+  }
+  pos = newline - data + 1;
+  return std::make_pair(begin - keep, pos - 1 - begin);
+}
+
+std::size_t LineReader::NextLines(std::vector<std::string_view>& lines, std::size_t maxLines) {
+  keep = pos;
+  // the buffer may move while the lines are read, so only their offsets
+  // (relative to `keep`) are stable
+  offsets.clear();
+  while (offsets.size() < maxLines) {
+    auto line = TakeLine();
+    if (!line) {
+      break;
+    }
+    offsets.push_back(*line);
+  }
+  for (const auto& [offset, length]: offsets) {
+    lines.emplace_back(data + keep + offset, length);
+  }
+  return offsets.size();
+}
+
+std::optional<std::string_view> LineReader::NextLine() {
+  keep = pos;
+  auto line = TakeLine();
+  if (!line) {
+    return std::nullopt;
+  }
+  return std::string_view{data + keep + line->first, line->second};
+}
+
+std::optional<std::string_view> LineReader::LastLine() {
+  if (mapped) {
+    if (pos == end) {
+      return std::nullopt;
+    }
+    std::string_view rest{data + pos, end - pos};
+    if (rest.back() == '\n') {
+      rest.remove_suffix(1);
+    }
+    auto newline = rest.rfind('\n');
+    pos = end;
+    return newline == std::string_view::npos ? rest : rest.substr(newline + 1);
+  }
+  bool found = false;
+  std::vector<std::string_view> lines;
+  while (NextLines(lines, BLOCK_SIZE) > 0) {
+    lastLine = lines.back();
+    lines.clear();
+    found = true;
+  }
+  if (!found) {
+    return std::nullopt;
+  }
+  return lastLine;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Reads the input line by line without copying the lines: a regular file is
+// memory-mapped as a whole, anything else (a pipe, a terminal) is read in large
+// blocks into a buffer the returned lines refer to.
+//
+// A line is returned without its '\n'. The returned views stay valid until the
+// next call of `NextLine`/`NextLines`/`LastLine` (for a mapped file - until the
+// reader is destroyed).
+//
+// An input longer than `maxBytes` is an error (`std::length_error` is thrown
+// as soon as it is noticed), so a reader never holds more than that.
+class LineReader {
+public:
+  // The reader doesn't own `fd`
+  explicit LineReader(int fd, std::size_t maxBytes = SIZE_MAX);
+
+  LineReader(const LineReader&) = delete;
+  LineReader& operator=(const LineReader&) = delete;
+
+  ~LineReader();
+
+  std::optional<std::string_view> NextLine();
+
+  // Appends at most `maxLines` lines to `lines`, all of them stay valid until
+  // the next call. Returns the number of appended lines (0 at the end of input)
+  std::size_t NextLines(std::vector<std::string_view>& lines, std::size_t maxLines);
+
+  // Skips the rest of the input and returns its last line (if any). The lines
+  // of a mapped file are not even read
+  std::optional<std::string_view> LastLine();
+
+  bool IsMapped() const {
+    return mapped;
+  }
+
+private:
+  static constexpr std::size_t BLOCK_SIZE = std::size_t{1} << 20;
+
+  // Makes sure that the buffer contains a whole line after `pos` (unless the
+  // input is exhausted). The data before `keep` may be dropped
+  void Refill();
+
+  // Returns the offset (relative to `keep`) and the length of the next line
+  std::optional<std::pair<std::size_t, std::size_t>> TakeLine();
+
+  int fd;
+  std::size_t limit;
+  std::size_t readBytes = 0;
+  bool mapped = false;
+  bool exhausted = false;
+  const char* data = nullptr;  // the mapped file or `buffer.data()`
+  std::size_t keep = 0;  // the start of the lines returned by the last call
+  std::size_t pos = 0;  // the start of the first line that was not returned
+  std::size_t end = 0;  // the end of the read data
+  std::size_t mappedSize = 0;
+  std::vector<char> buffer;
+  std::vector<std::pair<std::size_t, std::size_t>> offsets;
+  std::string lastLine;  // a copy of the last line for `LastLine` (when the
+                         // input is not mapped)
+};
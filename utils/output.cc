@@ -0,0 +1,76 @@
+#include "output.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <limits>
+#include <system_error>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+OutputWriter::OutputWriter(int outputFd, std::size_t bufferSize) : fd{outputFd}, buffer(std::max<std::size_t>(bufferSize, 64)) {
+}
+
+OutputWriter::~OutputWriter() {
+  try {
+    Flush();
+  } catch (const std::system_error&) {
+    // nowhere to report it
+  }
+}
+
+void OutputWriter::WriteUnsigned(std::size_t value) {
+  constexpr std::size_t MAX_DIGITS = std::numeric_limits<std::size_t>::digits10 + 1;
+  if (buffer.size() - used < MAX_DIGITS) {
+    Flush();
+  }
+  used = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+}
+
+std::size_t OutputWriter::LinesWritten() const {
+  return lines + std::count(buffer.data(), buffer.data() + used, '\n');
+}
+
+void OutputWriter::Flush() {
+  WriteThrough({});
+}
+
+void OutputWriter::WriteThrough(std::string_view data) {
+  iovec chunks[2] = {
+    {buffer.data(), used},
+    {const_cast<char*>(data.data()), data.size()},
+  };
+  iovec* first = chunks;
+  int count = 2;
+  flushed += used + data.size();
+  if (countLines) {
+    lines += std::count(buffer.data(), buffer.data() + used, '\n') + std::count(data.begin(), data.end(), '\n');
+  }
+  used = 0;
+  while (count > 0) {
+    if (first->iov_len == 0) {
+      first++;
+      count--;
+      continue;
+    }
+    ssize_t written = writev(fd, first, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error{errno, std::generic_category(), "Failed to write the output"};
+    }
+    // skip what was written (possibly partially)
+    for (std::size_t left = written; left > 0;) {
+      std::size_t skipped = std::min<std::size_t>(left, first->iov_len);
+      first->iov_base = static_cast<char*>(first->iov_base) + skipped;
+      first->iov_len -= skipped;
+      left -= skipped;
+      if (first->iov_len == 0 && left > 0) {
+        first++;
+        count--;
+      }
+    }
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Buffered output to a file descriptor: the data is accumulated in a large
+// buffer and written with write(2) only when the buffer is full (a chunk that
+// doesn't fit is written together with the buffer by a single writev(2)).
+// Nothing is flushed at the ends of lines.
+class OutputWriter {
+public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = std::size_t{1} << 20;
+
+  // The writer doesn't own `fd`
+  explicit OutputWriter(int fd, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  OutputWriter(const OutputWriter&) = delete;
+  OutputWriter& operator=(const OutputWriter&) = delete;
+
+  // Flushes the rest of the data
+  ~OutputWriter();
+
+  void Write(std::string_view data) {
+    if (data.size() <= buffer.size() - used) {
+      data.copy(buffer.data() + used, data.size());
+      used += data.size();
+    } else {
+      WriteThrough(data);
+    }
+  }
+
+  void Put(char c) {
+    if (used == buffer.size()) {
+      Flush();
+    }
+    buffer[used++] = c;
+  }
+
+  // Formats `value` in decimal right in the buffer
+  void WriteUnsigned(std::size_t value);
+
+  void Flush();
+
+  // The total number of bytes passed to the writer
+  std::size_t BytesWritten() const {
+    return flushed + used;
+  }
+
+  // Makes the writer count the lines ('\n' characters) passed to it, see
+  // `LinesWritten`. Must be called before anything is written
+  void CountLines() {
+    countLines = true;
+  }
+
+  std::size_t LinesWritten() const;
+
+  OutputWriter& operator<<(std::string_view data) {
+    Write(data);
+    return *this;
+  }
+
+  OutputWriter& operator<<(char c) {
+    Put(c);
+    return *this;
+  }
+
+  OutputWriter& operator<<(std::size_t value) {
+    WriteUnsigned(value);
+    return *this;
+  }
+
+private:
+  // Writes the buffer and `data` (which doesn't fit into the buffer)
+  void WriteThrough(std::string_view data);
+
+  int fd;
+  std::vector<char> buffer;
+  std::size_t used = 0;
+  std::size_t flushed = 0;
+  bool countLines = false;
+  std::size_t lines = 0;  // flushed
+};
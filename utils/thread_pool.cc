@@ -0,0 +1,154 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// The index of the worker that runs the current thread (if it's a worker)
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local std::size_t currentWorker = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t threadsCount) {
+  if (threadsCount == 0) {
+    threadsCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (std::size_t i = 0; i < threadsCount; i++) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i = 0; i < threadsCount; i++) {
+    threads.emplace_back([this, i] { Run(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  try {
+    Wait();
+  } catch (...) {
+    // nobody has waited for the task which has thrown it
+  }
+  {
+    std::lock_guard lock{mutex};
+    stopping = true;
+  }
+  hasTasks.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  // a worker pushes to its own deque (so the subtasks stay local), the other
+  // threads spread the tasks between the workers
+  std::size_t index = currentPool == this
+    ? currentWorker
+    : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+  pending.fetch_add(1);
+  {
+    // counted before it's pushed, so `queued` never underflows
+    std::lock_guard lock{mutex};
+    queued.fetch_add(1);
+  }
+  {
+    std::lock_guard lock{workers[index]->mutex};
+    workers[index]->tasks.push_back(std::move(task));
+  }
+  hasTasks.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock lock{mutex};
+  allDone.wait(lock, [this] { return pending.load() == 0; });
+  if (error) {
+    std::rethrow_exception(std::exchange(error, nullptr));
+  }
+}
+
+void ThreadPool::Group::Fail(std::exception_ptr exception) {
+  std::lock_guard lock{mutex};
+  if (!error) {
+    error = exception;
+  }
+  failed.store(true);
+}
+
+void ThreadPool::Group::Complete() {
+  // under the lock, so that the waiter can't see the last completion (and
+  // destroy the group) before it is notified
+  std::lock_guard lock{mutex};
+  if (remaining.fetch_sub(1) == 1) {
+    done.notify_all();
+  }
+}
+
+void ThreadPool::WaitFor(Group& group) {
+  if (currentPool == this) {
+    // the tasks of the group may be queued behind the task which waits for
+    // them, so the worker runs them itself (and whatever else it finds)
+    std::function<void()> task;
+    while (group.remaining.load() > 0 && TryPop(currentWorker, task)) {
+      RunTask(task);
+    }
+  }
+  // the rest of the tasks are running on the other workers
+  std::unique_lock lock{group.mutex};
+  group.done.wait(lock, [&group] { return group.remaining.load() == 0; });
+}
+
+bool ThreadPool::TryPop(std::size_t index, std::function<void()>& task) {
+  {
+    auto& own = *workers[index];
+    std::lock_guard lock{own.mutex};
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (std::size_t shift = 1; shift < workers.size(); shift++) {
+    auto& victim = *workers[(index + shift) % workers.size()];
+    std::lock_guard lock{victim.mutex};
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::RunTask(std::function<void()>& task) {
+  queued.fetch_sub(1);
+  try {
+    task();
+  } catch (...) {
+    std::lock_guard lock{mutex};
+    if (!error) {
+      error = std::current_exception();
+    }
+  }
+  task = nullptr;  // the captured state is released before reporting
+  if (pending.fetch_sub(1) == 1) {
+    std::lock_guard lock{mutex};
+    allDone.notify_all();
+  }
+}
+
+void ThreadPool::Run(std::size_t index) {
+  currentPool = this;
+  currentWorker = index;
+  while (true) {
+    std::function<void()> task;
+    if (TryPop(index, task)) {
+      RunTask(task);
+      continue;
+    }
+    std::unique_lock lock{mutex};
+    hasTasks.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping && queued.load() == 0) {
+      return;
+    }
+  }
+}
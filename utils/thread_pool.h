@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool: every worker has its own deque of tasks, takes
+// the tasks from the back of its deque and, when the deque is empty, steals
+// from the front of the others' deques. The tasks submitted from outside of
+// the pool are distributed between the workers round-robin.
+//
+// An exception thrown by a task doesn't stop the worker: it is kept and
+// rethrown by `Wait` (or by the `ParallelFor` that has submitted the task).
+class ThreadPool {
+public:
+  // `threadsCount` == 0 means one thread per hardware thread
+  explicit ThreadPool(std::size_t threadsCount);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Waits for the submitted tasks to complete
+  ~ThreadPool();
+
+  void Submit(std::function<void()> task);
+
+  // Blocks until all the submitted tasks are completed. Rethrows the first
+  // exception thrown by a submitted task since the previous `Wait`
+  void Wait();
+
+  // Runs `body(i)` for every i in [begin, end) (split into chunks of `grain`
+  // iterations) and waits for all of them (but not for the other tasks of the
+  // pool, so it may be called from a task; a worker runs the queued tasks
+  // while it waits). Rethrows the first exception thrown by `body`, the
+  // chunks that haven't started by then are skipped
+  template<typename TBody>
+  void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, const TBody& body) {
+    grain = std::max<std::size_t>(grain, 1);
+    Group group;
+    for (std::size_t chunk = begin; chunk < end; chunk += grain) {
+      std::size_t chunkEnd = std::min(end, chunk + grain);
+      group.remaining.fetch_add(1);
+      Submit([&body, &group, chunk, chunkEnd] {
+        if (!group.failed.load()) {
+          try {
+            for (std::size_t i = chunk; i < chunkEnd; i++) {
+              body(i);
+            }
+          } catch (...) {
+            group.Fail(std::current_exception());
+          }
+        }
+        group.Complete();
+      });
+    }
+    WaitFor(group);
+    if (group.error) {
+      std::rethrow_exception(group.error);
+    }
+  }
+
+  std::size_t Size() const {
+    return workers.size();
+  }
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // The tasks of a `ParallelFor`, which don't touch it after `Complete`
+  struct Group {
+    std::atomic<std::size_t> remaining{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;  // the first one, set under `mutex`
+    std::mutex mutex;
+    std::condition_variable done;
+
+    void Fail(std::exception_ptr exception);
+
+    void Complete();
+  };
+
+  void WaitFor(Group& group);
+
+  void Run(std::size_t index);
+
+  bool TryPop(std::size_t index, std::function<void()>& task);
+
+  // Runs a popped task and reports its completion
+  void RunTask(std::function<void()>& task);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;  // guards the sleeping and the waiting
+  std::condition_variable hasTasks;
+  std::condition_variable allDone;
+  std::atomic<std::size_t> queued{0};   // submitted but not taken yet
+  std::atomic<std::size_t> pending{0};  // submitted but not completed yet
+  std::atomic<std::size_t> nextWorker{0};
+  bool stopping = false;
+  std::exception_ptr error;  // thrown by a submitted task, guarded by `mutex`
+};
@@ -0,0 +1,109 @@
+#include "unix_socket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+  throw std::system_error{errno, std::generic_category(), what};
+}
+
+sockaddr_un MakeAddress(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    errno = ENAMETOOLONG;
+    ThrowErrno("Bad socket path '" + path + "'");
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+// Connects a new socket to `address`. Returns -1 (keeping errno) on failure
+int TryConnect(const sockaddr_un& address) {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  while (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    if (errno != EINTR) {
+      const int error = errno;
+      close(fd);
+      errno = error;
+      return -1;
+    }
+  }
+  return fd;
+}
+
+}  // namespace
+
+UnixListener::UnixListener(const std::string& socketPath, int backlog) : path{socketPath} {
+  const auto address = MakeAddress(path);
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    // the file is left by a listener that is gone, unless somebody answers
+    if (int other = TryConnect(address); other >= 0) {
+      close(other);
+      errno = EADDRINUSE;
+      ThrowErrno("Somebody listens on '" + path + "'");
+    }
+    unlink(path.c_str());
+  }
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    ThrowErrno("Failed to create a socket");
+  }
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, backlog) != 0) {
+    const int error = errno;
+    close(fd);
+    errno = error;
+    ThrowErrno("Failed to listen on '" + path + "'");
+  }
+}
+
+UnixListener::~UnixListener() {
+  close(fd);
+  unlink(path.c_str());
+}
+
+int UnixListener::Accept() {
+  while (true) {
+    int connection = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection >= 0) {
+      return connection;
+    }
+    if (errno == EINTR) {
+      return -1;
+    }
+    if (errno != ECONNABORTED) {
+      ThrowErrno("Failed to accept a connection");
+    }
+  }
+}
+
+int ConnectUnix(const std::string& socketPath) {
+  int fd = TryConnect(MakeAddress(socketPath));
+  if (fd < 0) {
+    ThrowErrno("Failed to connect to '" + socketPath + "'");
+  }
+  return fd;
+}
+
+void SetIoTimeout(int fd, std::chrono::milliseconds timeout) {
+  timeval value{};
+  value.tv_sec = timeout.count() / 1000;
+  value.tv_usec = timeout.count() % 1000 * 1000;
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value)) != 0 ||
+      setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value)) != 0) {
+    ThrowErrno("Failed to set the timeout of a connection");
+  }
+}
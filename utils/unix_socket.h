@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// A listening Unix domain stream socket. The socket file is created by the
+// constructor (a stale one, which nobody listens on, is replaced) and removed
+// by the destructor
+class UnixListener {
+public:
+  // Throws `std::system_error` if the socket can't be created
+  explicit UnixListener(const std::string& socketPath, int backlog = 128);
+
+  UnixListener(const UnixListener&) = delete;
+  UnixListener& operator=(const UnixListener&) = delete;
+
+  ~UnixListener();
+
+  // Returns the descriptor of an accepted connection (the caller owns it) or
+  // -1 if accept(2) was interrupted by a signal
+  int Accept();
+
+  // For poll(2)
+  int GetFd() const {
+    return fd;
+  }
+
+private:
+  std::string path;
+  int fd;
+};
+
+// Connects to the socket at `socketPath` and returns the descriptor (the
+// caller owns it). Throws `std::system_error` on failure
+int ConnectUnix(const std::string& socketPath);
+
+// Makes a read from or a write to the socket `fd` fail with EAGAIN if it has
+// waited for `timeout`. Throws `std::system_error` on failure
+void SetIoTimeout(int fd, std::chrono::milliseconds timeout);